@@ -2,7 +2,65 @@
 ALLEGRO_FONT *fonts[5];
 
 //Variable for storing the images to help with loading and destroying
-ALLEGRO_BITMAP *images[12];
+const int num_images = 14;
+ALLEGRO_BITMAP *images[num_images];
 
-//Sound effects
-ALLEGRO_SAMPLE *sounds[7];
\ No newline at end of file
+//The texture all of the images above are packed in to, NULL if they wouldn't fit in one
+ALLEGRO_BITMAP *atlas = NULL;
+
+//Sound effects, in the same order as SOUNDS in simulation.h
+ALLEGRO_SAMPLE *sounds[num_sounds];
+
+//How many of each sound can play at once, which wins when they run out, and how quickly each can retrigger.
+//Dying is the highest so it always gets a voice
+const VoiceSettings sound_settings[num_sounds] =
+{
+  {4, 1, 0.03}, //Coin
+  {2, 2, 0.05}, //Star
+  {1, 10, 0}, //Die
+  {2, 3, 0.05}, //Jump
+  {2, 3, 0.05}, //Double jump
+  {1, 5, 0.1} //Pause
+};
+
+//Most sound effects playing at once, the theme tune doesn't count
+const int max_playing_sounds = 8;
+
+//The theme tune, streamed and decoded a bit at a time as it plays rather than all up front
+ALLEGRO_AUDIO_STREAM *song_stream = NULL;
+
+//Every file that's loaded in the background, in the order they load.
+//The title and the menu font go first so the menu can show while the rest are still coming in
+Asset assets[] =
+{
+  {ASSET_BITMAP, "Assets/Images/Title.png", 0, 11, NULL},
+  {ASSET_FONT, "Assets/Fonts/big_noodle_titling.ttf", 28, 1, NULL},
+  {ASSET_BITMAP, "Assets/Images/Instructions.png", 0, 10, NULL},
+  {ASSET_BITMAP, "Assets/Images/Mario-Stand.png", 0, 0, NULL},
+  {ASSET_BITMAP, "Assets/Images/Mario-Run.png", 0, 1, NULL},
+  {ASSET_BITMAP, "Assets/Images/Mario-Skid.png", 0, 2, NULL},
+  {ASSET_BITMAP, "Assets/Images/Mario-Jump.png", 0, 3, NULL},
+  {ASSET_BITMAP, "Assets/Images/Platform2.png", 0, 4, NULL},
+  {ASSET_BITMAP, "Assets/Images/Background.png", 0, 5, NULL},
+  {ASSET_BITMAP, "Assets/Images/Coin.png", 0, 6, NULL},
+  {ASSET_BITMAP, "Assets/Images/Heart.png", 0, 7, NULL},
+  {ASSET_BITMAP, "Assets/Images/Pause.png", 0, 8, NULL},
+  {ASSET_BITMAP, "Assets/Images/Star.png", 0, 9, NULL},
+  {ASSET_BITMAP, "Assets/Images/Enemy-Walk.png", 0, 12, NULL},
+  {ASSET_BITMAP, "Assets/Images/Enemy-Die.png", 0, 13, NULL},
+  {ASSET_FONT, "Assets/Fonts/arial.ttf", 16, 0, NULL},
+  {ASSET_FONT, "Assets/Fonts/big_noodle_titling.ttf", 42, 2, NULL},
+  {ASSET_FONT, "Assets/Fonts/big_noodle_titling.ttf", 58, 3, NULL},
+  {ASSET_FONT, "Assets/Fonts/big_noodle_titling.ttf", 20, 4, NULL},
+  {ASSET_SAMPLE, "Assets/Audio/coin.wav", 0, 0, NULL},
+  {ASSET_SAMPLE, "Assets/Audio/star.wav", 0, 1, NULL},
+  {ASSET_SAMPLE, "Assets/Audio/mariodie.wav", 0, 2, NULL},
+  {ASSET_SAMPLE, "Assets/Audio/jump.wav", 0, 3, NULL},
+  {ASSET_SAMPLE, "Assets/Audio/doublejump.wav", 0, 4, NULL},
+  {ASSET_SAMPLE, "Assets/Audio/pause.wav", 0, 5, NULL}
+};
+
+const int num_assets = sizeof(assets) / sizeof(assets[0]);
+
+//How many of assets have been taken from the loader and put in the arrays above
+int assets_taken = 0;
@@ -0,0 +1,95 @@
+#include <algorithm>
+#include <vector>
+
+#include "atlas.h"
+
+using namespace std;
+
+//Sort tallest first, shelf packing wastes the least space that way
+static bool TallerThan(ALLEGRO_BITMAP *a, ALLEGRO_BITMAP *b)
+{
+  return al_get_bitmap_height(a) > al_get_bitmap_height(b);
+}
+
+ALLEGRO_BITMAP *BuildAtlas(ALLEGRO_BITMAP **bitmaps, int count, int max_width)
+{
+  int max_size = al_get_display_option(al_get_current_display(), ALLEGRO_MAX_BITMAP_SIZE);
+
+  if (max_size > 0 && max_width > max_size)
+    max_width = max_size;
+
+  //Anything that failed to load is left out, and left NULL
+  vector<ALLEGRO_BITMAP *> order;
+
+  for (int i = 0; i < count; ++i)
+  {
+    if (bitmaps[i])
+      order.push_back(bitmaps[i]);
+  }
+
+  if (order.empty())
+    return NULL;
+
+  stable_sort(order.begin(), order.end(), TallerThan);
+
+  //Shelf pack, fill a row left to right and start a new row below when the next one won't fit
+  int packed = order.size();
+  vector<int> xs(packed), ys(packed);
+  int x = 0, y = 0, row_height = 0, width = 0;
+
+  for (int i = 0; i < packed; ++i)
+  {
+    int w = al_get_bitmap_width(order[i]) + atlas_padding * 2;
+    int h = al_get_bitmap_height(order[i]) + atlas_padding * 2;
+
+    if (w > max_width)
+      return NULL;
+
+    if (x + w > max_width)
+    {
+      x = 0;
+      y += row_height;
+      row_height = 0;
+    }
+
+    xs[i] = x + atlas_padding;
+    ys[i] = y + atlas_padding;
+
+    x += w;
+    row_height = max(row_height, h);
+    width = max(width, x);
+  }
+
+  int height = y + row_height;
+
+  if (max_size > 0 && height > max_size)
+    return NULL;
+
+  ALLEGRO_BITMAP *atlas = al_create_bitmap(width, height);
+
+  if (!atlas)
+    return NULL;
+
+  ALLEGRO_BITMAP *old_target = al_get_target_bitmap();
+  al_set_target_bitmap(atlas);
+  al_clear_to_color(al_map_rgba(0,0,0,0));
+
+  for (int i = 0; i < packed; ++i)
+    al_draw_bitmap(order[i], xs[i], ys[i], 0);
+
+  al_set_target_bitmap(old_target);
+
+  for (int i = 0; i < count; ++i)
+  {
+    if (!bitmaps[i])
+      continue;
+
+    int j = find(order.begin(), order.end(), bitmaps[i]) - order.begin();
+    ALLEGRO_BITMAP *region = al_create_sub_bitmap(atlas, xs[j], ys[j], al_get_bitmap_width(bitmaps[i]), al_get_bitmap_height(bitmaps[i]));
+
+    al_destroy_bitmap(bitmaps[i]);
+    bitmaps[i] = region;
+  }
+
+  return atlas;
+}
@@ -0,0 +1,19 @@
+//Packs a set of bitmaps in to one big texture.
+//Each bitmap is replaced by a sub-bitmap of the atlas so existing drawing code keeps working,
+//but everything drawn from the atlas between al_hold_bitmap_drawing(true) and (false) goes to the gpu in one batch.
+
+#ifndef ATLAS_H
+#define ATLAS_H
+
+#include <Allegro5\allegro.h>
+
+//Empty space left around each bitmap so filtering never picks up its neighbours
+const int atlas_padding = 1;
+
+//Packs count bitmaps in to a new video bitmap no wider than max_width and returns it.
+//On success every bitmaps[i] is destroyed and replaced with a sub-bitmap of the atlas, destroy those before the atlas.
+//NULL entries are skipped and stay NULL.
+//Returns NULL and leaves bitmaps alone if they won't fit in a texture the display can handle, or there's nothing to pack.
+ALLEGRO_BITMAP *BuildAtlas(ALLEGRO_BITMAP **bitmaps, int count, int max_width);
+
+#endif
@@ -0,0 +1,190 @@
+#include <cstring>
+
+#include "bot.h"
+
+static Rect PlatformBox(const Game &game, int slot)
+{
+  Rect box;
+  box.top_left.x = game.platforms.x[slot];
+  box.top_left.y = game.platforms.y[slot];
+  box.bottom_right.x = game.platforms.right[slot];
+  box.bottom_right.y = game.platforms.bottom[slot];
+  return box;
+}
+
+//Brings a sideways distance in to the shorter way round the wrap, negative is left
+static int Wrapped(const Bot &bot, int distance)
+{
+  int wrap = bot.jumps.wrap;
+
+  distance %= wrap;
+
+  if (distance >= wrap / 2)
+    distance -= wrap;
+  else if (distance < -wrap / 2)
+    distance += wrap;
+
+  return distance;
+}
+
+//Where the player's x has to be to stand in the middle of platform
+static int Middle(const Bot &bot, const Rect &platform)
+{
+  return (platform.top_left.x - bot.jumps.width + platform.bottom_right.x) / 2;
+}
+
+//Runs towards x, letting go in time to stop there. It brakes early rather than overshoot, the duplicate speed
+//update in UpdatePlayer makes the real stop shorter than deceleration says
+static unsigned int Steer(const Bot &bot, const Player &player, int x)
+{
+  int distance = Wrapped(bot, x - player.x);
+  float stopping = player.speed * player.speed / (2 * player.deceleration);
+
+  if ((distance > 0 && player.speed > 0 && distance <= stopping) || (distance < 0 && player.speed < 0 && -distance <= stopping))
+    return 0;
+
+  if (distance > bot_slack)
+    return 1u << RIGHT;
+
+  if (distance < -bot_slack)
+    return 1u << LEFT;
+
+  return 0;
+}
+
+//Stood on a platform, heads for the spot to jump to the next one up from and jumps once it's in reach
+static unsigned int TakeOff(Bot &bot, const Game &game)
+{
+  const Player &player = game.player;
+  int slot = PlayerCollidePlatforms(game);
+
+  if (slot < 0)
+    return 0;
+
+  int n = (slot - game.first_platform + max_platforms) % max_platforms;
+
+  if (n + 1 >= game.num_platforms)
+    return 0;
+
+  Rect from = PlatformBox(game, slot);
+  Rect to = PlatformBox(game, PlatformSlot(game, n + 1));
+
+  //As close under the middle of the next one as this one goes
+  int goal = player.x + Wrapped(bot, Middle(bot, to) - player.x);
+  int left = from.top_left.x - bot.jumps.width + bot_edge_margin;
+  int right = from.bottom_right.x - bot_edge_margin;
+
+  if (goal < left)
+    goal = left;
+  else if (goal > right)
+    goal = right;
+
+  int second = PlanJump(bot.jumps, player.x, from, to);
+  bool in_reach = second == 0 || (second > 0 && game.stars > 0);
+  bool at_goal = Wrapped(bot, goal - player.x) >= -bot_slack && Wrapped(bot, goal - player.x) <= bot_slack;
+
+  //Running away from where it's going would take it off the arc the plan is for
+  int heading = Wrapped(bot, Middle(bot, to) - player.x);
+  bool slowed = player.speed * heading >= 0 || (player.speed < 1 && player.speed > -1);
+
+  //Jump anyway from the best spot when it can't be made, dropping back to the platform and trying again beats
+  //standing there until the screen scrolls away
+  if ((in_reach && slowed) || (at_goal && player.speed == 0))
+  {
+    bot.jumping = true;
+    bot.target = to;
+    bot.airborne = 0;
+    bot.second_jump = second > 0 && game.stars > 0 ? second : 0;
+
+    return (1u << UP) | Steer(bot, player, Middle(bot, to));
+  }
+
+  return Steer(bot, player, goal);
+}
+
+//Steers for the middle of the platform it jumped for, and jumps again on the planned tick
+static unsigned int Fly(Bot &bot, const Game &game)
+{
+  unsigned int keys = Steer(bot, game.player, Middle(bot, bot.target));
+
+  ++bot.airborne;
+
+  if (bot.second_jump > 0 && bot.airborne == bot.second_jump)
+    keys |= 1u << UP;
+
+  return keys;
+}
+
+void InitBot(Bot &bot, const Game &game)
+{
+  MeasureJumps(game, bot.jumps);
+
+  bot.keys = 0;
+  bot.was_over = false;
+  bot.jumping = false;
+  bot.airborne = 0;
+  bot.second_jump = 0;
+
+  memset(&bot.target, 0, sizeof(bot.target));
+  memset(&bot.stats, 0, sizeof(bot.stats));
+}
+
+unsigned int BotInput(Bot &bot, const Game &game)
+{
+  bool over = game.current_state == GAME && game.game_over;
+  unsigned int keys = 0;
+
+  if (over && !bot.was_over)
+  {
+    BotStats &stats = bot.stats;
+
+    ++stats.games;
+    stats.last_climb = game.highest;
+    stats.last_score = (game.highest / 2) + game.score;
+    stats.total_climb += game.highest;
+
+    if (game.highest > stats.best_climb)
+      stats.best_climb = game.highest;
+  }
+
+  bot.was_over = over;
+
+  if (game.current_state != GAME)
+  {
+    //Back out of the instructions or high scores, up to the top of the menu and start
+    if (game.current_state != MENU)
+      keys = 1u << ESCAPE;
+    else if (game.menu_selection != 0)
+      keys = 1u << UP;
+    else
+      keys = 1u << ENTER;
+
+    bot.jumping = false;
+  }
+  else if (game.game_over)
+  {
+    keys = 1u << R;
+    bot.jumping = false;
+  }
+  else if (game.paused)
+  {
+    keys = 1u << P;
+  }
+  else if (game.player.state == game.player.WALKING)
+  {
+    bot.jumping = false;
+    keys = TakeOff(bot, game);
+  }
+  else if (bot.jumping)
+  {
+    keys = Fly(bot, game);
+  }
+
+  //Everything but running only happens when a key is first pressed, so anything else held last tick is let go of
+  //for one tick before it's pressed again
+  unsigned int held = (1u << LEFT) | (1u << RIGHT);
+  keys &= ~(bot.keys & ~held);
+
+  bot.keys = keys;
+  return keys;
+}
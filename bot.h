@@ -0,0 +1,50 @@
+//Autopilot for soak and performance runs, plays the game with nobody at the keyboard.
+//Each tick it looks at the player and the platforms and gives back the input mask a player would, jumping for the
+//next platform up. Jumps are planned with jumps.h so it moves by the same rules as UpdatePlayer, double jumping
+//when it has a star and the gap needs one. Games are restarted as soon as they end, so it can be left for hours.
+//It draws nothing random and only reads the game, so a run with the bot records and replays like any other.
+
+#ifndef BOT_H
+#define BOT_H
+
+#include "simulation.h"
+#include "jumps.h"
+
+//Pixels either side of where it's heading that count as there
+const int bot_slack = 2;
+
+//How far in from the ends of a platform it will take off from, so it doesn't walk off while stopping
+const int bot_edge_margin = 4;
+
+struct BotStats
+{
+  int games; //Finished so far
+  int last_climb; //Highest point reached in the last finished game, the same as game.highest
+  int last_score; //The score it would have submitted
+  int best_climb;
+  long long total_climb;
+};
+
+struct Bot
+{
+  Jumps jumps;
+
+  unsigned int keys; //What it gave last tick, so it can let go of a key before pressing it again
+  bool was_over; //The game was over last tick
+
+  //The jump it's in the middle of
+  bool jumping;
+  Rect target;
+  int airborne; //Ticks since it jumped
+  int second_jump; //Tick of the jump to jump again on, 0 if it isn't
+
+  BotStats stats;
+};
+
+void InitBot(Bot &bot, const Game &game); //Measures the player's jumps, call after InitGame
+
+//Returns the input for the next step. A game that's just ended is counted in bot.stats the first time it's seen,
+//so a front end can tell one has finished by games going up
+unsigned int BotInput(Bot &bot, const Game &game);
+
+#endif
@@ -0,0 +1,124 @@
+#include <cstring>
+
+#include "collision.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define COLLISION_AVX2
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define COLLISION_SSE2
+#endif
+
+//Tests entities from to count one at a time, setting their bits without clearing anything
+static int OverlapRange(const int *left, const int *top, const int *right, const int *bottom, int from, int count, const Rect &box, unsigned int *hits)
+{
+  int found = 0;
+
+  for (int i = from; i < count; ++i)
+  {
+    if (left[i] < box.bottom_right.x && right[i] > box.top_left.x && top[i] < box.bottom_right.y && bottom[i] > box.top_left.y)
+    {
+      hits[i / 32] |= 1u << (i % 32);
+      ++found;
+    }
+  }
+
+  return found;
+}
+
+#if defined(COLLISION_AVX2) || defined(COLLISION_SSE2)
+//Number of bits set in mask
+static int CountBits(unsigned int mask)
+{
+  int count = 0;
+
+  while (mask)
+  {
+    mask &= mask - 1;
+    ++count;
+  }
+
+  return count;
+}
+#endif
+
+int OverlapBoxes(const int *left, const int *top, const int *right, const int *bottom, int count, const Rect &box, unsigned int *hits)
+{
+  memset(hits, 0, HitWords(count) * sizeof(unsigned int));
+
+  int found = 0;
+  int i = 0;
+
+#if defined(COLLISION_AVX2)
+  __m256i box_left = _mm256_set1_epi32(box.top_left.x);
+  __m256i box_top = _mm256_set1_epi32(box.top_left.y);
+  __m256i box_right = _mm256_set1_epi32(box.bottom_right.x);
+  __m256i box_bottom = _mm256_set1_epi32(box.bottom_right.y);
+
+  //8 at a time, 8 goes in to 32 so each group lands in one word of the mask
+  for (; i + 8 <= count; i += 8)
+  {
+    __m256i hit = _mm256_cmpgt_epi32(box_right, _mm256_loadu_si256((const __m256i *)(left + i)));
+    hit = _mm256_and_si256(hit, _mm256_cmpgt_epi32(_mm256_loadu_si256((const __m256i *)(right + i)), box_left));
+    hit = _mm256_and_si256(hit, _mm256_cmpgt_epi32(box_bottom, _mm256_loadu_si256((const __m256i *)(top + i))));
+    hit = _mm256_and_si256(hit, _mm256_cmpgt_epi32(_mm256_loadu_si256((const __m256i *)(bottom + i)), box_top));
+
+    unsigned int mask = (unsigned int)_mm256_movemask_ps(_mm256_castsi256_ps(hit));
+
+    if (mask)
+    {
+      hits[i / 32] |= mask << (i % 32);
+      found += CountBits(mask);
+    }
+  }
+#elif defined(COLLISION_SSE2)
+  __m128i box_left = _mm_set1_epi32(box.top_left.x);
+  __m128i box_top = _mm_set1_epi32(box.top_left.y);
+  __m128i box_right = _mm_set1_epi32(box.bottom_right.x);
+  __m128i box_bottom = _mm_set1_epi32(box.bottom_right.y);
+
+  //4 at a time, 4 goes in to 32 so each group lands in one word of the mask
+  for (; i + 4 <= count; i += 4)
+  {
+    __m128i hit = _mm_cmplt_epi32(_mm_loadu_si128((const __m128i *)(left + i)), box_right);
+    hit = _mm_and_si128(hit, _mm_cmpgt_epi32(_mm_loadu_si128((const __m128i *)(right + i)), box_left));
+    hit = _mm_and_si128(hit, _mm_cmplt_epi32(_mm_loadu_si128((const __m128i *)(top + i)), box_bottom));
+    hit = _mm_and_si128(hit, _mm_cmpgt_epi32(_mm_loadu_si128((const __m128i *)(bottom + i)), box_top));
+
+    unsigned int mask = (unsigned int)_mm_movemask_ps(_mm_castsi128_ps(hit));
+
+    if (mask)
+    {
+      hits[i / 32] |= mask << (i % 32);
+      found += CountBits(mask);
+    }
+  }
+#endif
+
+  //Whatever didn't fill a whole group
+  return found + OverlapRange(left, top, right, bottom, i, count, box, hits);
+}
+
+int OverlapBoxesScalar(const int *left, const int *top, const int *right, const int *bottom, int count, const Rect &box, unsigned int *hits)
+{
+  memset(hits, 0, HitWords(count) * sizeof(unsigned int));
+
+  return OverlapRange(left, top, right, bottom, 0, count, box, hits);
+}
+
+int NextHit(const unsigned int *hits, int count, int from)
+{
+  for (int i = from; i < count; ++i)
+  {
+    unsigned int word = hits[i / 32] >> (i % 32);
+
+    //Skip the rest of an empty word in one go
+    if (word == 0)
+      i = (i / 32) * 32 + 31;
+    else if (word & 1)
+      return i;
+  }
+
+  return count;
+}
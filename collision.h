@@ -0,0 +1,26 @@
+//Box overlap tests against a whole array of entities at once.
+//Each entity is given by its edges in separate arrays, the layout the simulation keeps them in, so the tests run
+//4 or 8 at a time with SSE2 or AVX2 when the compiler is targeting them and one at a time everywhere else.
+
+#ifndef COLLISION_H
+#define COLLISION_H
+
+#include "objects.h"
+
+//Number of words needed in a hit mask for count entities
+inline int HitWords(int count)
+{
+  return (count + 31) / 32;
+}
+
+//Sets bit i of hits for every entity i whose box overlaps box, touching edges don't count.
+//hits needs HitWords(count) words, they're cleared first. Returns the number of hits
+int OverlapBoxes(const int *left, const int *top, const int *right, const int *bottom, int count, const Rect &box, unsigned int *hits);
+
+//The same one entity at a time, what OverlapBoxes falls back to without SSE2. Here for comparing against
+int OverlapBoxesScalar(const int *left, const int *top, const int *right, const int *bottom, int count, const Rect &box, unsigned int *hits);
+
+//Returns the first hit at or after from, or count if there are no more
+int NextHit(const unsigned int *hits, int count, int from);
+
+#endif
@@ -0,0 +1,78 @@
+#include <string>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include "files.h"
+
+using namespace std;
+
+unsigned int Checksum(const void *data, size_t size)
+{
+  const unsigned char *bytes = (const unsigned char *)data;
+  unsigned int hash = 2166136261u;
+
+  for (size_t i = 0; i < size; ++i)
+  {
+    hash ^= bytes[i];
+    hash *= 16777619u;
+  }
+
+  return hash;
+}
+
+bool SyncFile(FILE *file)
+{
+  if (fflush(file) != 0)
+    return false;
+
+#ifdef _WIN32
+  return _commit(_fileno(file)) == 0;
+#else
+  return fsync(fileno(file)) == 0;
+#endif
+}
+
+bool TruncateFile(FILE *file, long size)
+{
+  if (fflush(file) != 0)
+    return false;
+
+#ifdef _WIN32
+  return _chsize(_fileno(file), size) == 0;
+#else
+  return ftruncate(fileno(file), size) == 0;
+#endif
+}
+
+bool RenameOver(const char *from, const char *to, bool durable)
+{
+#ifdef _WIN32
+  return MoveFileExA(from, to, MOVEFILE_REPLACE_EXISTING | (durable ? MOVEFILE_WRITE_THROUGH : 0)) != 0;
+#else
+  if (rename(from, to) != 0)
+    return false;
+
+  if (!durable)
+    return true;
+
+  //The rename itself lives in the directory, sync that too
+  string path = to;
+  size_t slash = path.rfind('/');
+  string directory = slash == string::npos ? "." : path.substr(0, slash + 1);
+  int handle = open(directory.c_str(), O_RDONLY);
+
+  if (handle >= 0)
+  {
+    fsync(handle);
+    close(handle);
+  }
+
+  return true;
+#endif
+}
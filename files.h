@@ -0,0 +1,22 @@
+//Helpers for writing files that have to survive the game crashing or the machine losing power part way through,
+//shared by the leaderboard, the score spool and snapshots. Each caller says how far it wants a write to be trusted,
+//waiting for the disk is slow and not everything needs it.
+
+#ifndef FILES_H
+#define FILES_H
+
+#include <cstddef>
+#include <cstdio>
+
+//FNV-1a over size bytes, plenty to spot something that was only part written or belongs to something else
+unsigned int Checksum(const void *data, size_t size);
+
+bool SyncFile(FILE *file); //Makes sure everything written to file is on the disk and not just in a cache
+bool TruncateFile(FILE *file, long size); //Cuts file down to size bytes, anything appended after goes on from there
+
+//Renames from over the top of to in one step, so anything opening to gets one or the other whole. With durable the
+//rename is on the disk before it returns too, so a power cut straight after can't bring back the old file. Without,
+//it only guards against the game crashing
+bool RenameOver(const char *from, const char *to, bool durable);
+
+#endif
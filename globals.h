@@ -1,133 +1,194 @@
-//THe FPS of the game
-const int FPS = 60;
-
-//Width and height of the window
-const int WIDTH = 400;
-const int HEIGHT = 600;
-
-//Maximum number of platforms at any one time
-const int max_platforms = 12;
-
-//Maximum number of pickups at any one time
-const int max_pickups = 12;
-
-//Number of characters available for saving highscore names
-const int num_chars = 28;
-
-//Array of characters for saving highscore names
-const char name_chars[num_chars] = "ABCDEFGHIJKLMNOPQRSTUVWXYZ.";
-
-//Keeps track of the number of platforms currently alive
-int num_platforms = 0;
-
 //Setting this to true will close the game
 bool done = false;
 
 //Keeps track of whether or not we need to redraw the screen
 bool redraw = true;
 
-//Keeps track of the pressed state of each key, true means key is down
-enum KEYS{UP, DOWN, LEFT, RIGHT, X, Z, R, P, S, ENTER};
-const int num_keys = 10;
-bool keys[num_keys] = {false, false, false, false, false, false, false, false, false, false};
-bool old_keys[num_keys] = {false, false, false, false, false, false, false, false, false, false};
-
-//Keeps track of the state, changing current_state will switch the state.
-enum STATES{GAME, MENU, INSTRUCTIONS};
-int current_state = MENU;
+//Keeps track of the pressed state of each key, true means key is down. Packed in to the input mask for StepGame
+bool keys[num_keys] = {false, false, false, false, false, false, false, false, false, false, false};
 
-//Used for the FPS counter
+//Used for the FPS counter, counts frames drawn
 float game_time = 0;
 int frames = 0;
 int game_fps = 0;
 
-int skips = 0;
-
-//The allegro_display
-ALLEGRO_DISPLAY *display = NULL;
-
-//Sample instance for theme tune
-ALLEGRO_SAMPLE_INSTANCE *song_instance = NULL;
-
-//Keeps track of if the game is paused or not
-bool paused = false;
-
-//Set this to true to reset everything for a new game
-bool new_game = true;
+//Profiler overlay, toggled with F1. The stats shown are only worked out every profiler_refresh frames
+bool show_profiler = false;
+bool profile_run = false; //Started with -profile, so profiling stays on with the overlay closed
+ProfileStats profiler_stats[num_profile_sections];
+int profiler_refresh = 0;
 
-//When this is true display game over screen
-bool game_over = false;
+//When the last frame was flipped, for timing whole frames
+double last_flip = 0;
 
-//Set this to true to start the automatic scrolling upwards
-bool scrolling = false;
+//Number of trace files written with F2, for naming them
+int traces = 0;
 
-//The current speed of the upward scroll
-float scroll_speed = 1;
+//True when scores are being sent to an online leaderboard as well, set with -scores host:port[/path]
+bool sending_scores = false;
 
-//The maximum possible scroll speed
-float max_scroll_speed = 5;
+//Frames slower than this many milliseconds dump a trace of the last 5 seconds, 0 turns it off. Set with -hitch
+double hitch_time = 0;
+double last_hitch = 0;
+int hitches = 0;
 
-//Keeps track of the highest point reached so far
-int highest = 0;
+//True while the timer is stopped because nothing will change until a key is pressed, see GameIdle
+bool idle = false;
 
-//Keeps track of the total score
-int score = 0;
+//When the run started and how long of it was spent idle, and frames drawn, for the usage report with -profile
+double run_start = 0;
+double idle_start = 0;
+double idle_time = 0;
+long long frames_drawn = 0;
 
-int coins = 0;
+//Percentage of one core used by the whole process over the last second, shown with the FPS
+double cpu_usage = 0;
+double last_cpu_time = 0;
 
-//A bit hacky, keeps track of where zero score should be
-int zero;
-
-//Keeps track of the dificulty, increase this to make the game wait longer before spawning a new platform
-float dificulty = 1;
-
-//Max dificulty, make sure player can always make the jumps
-float max_dificulty = 2;
-
-//The minimum amount of space between each platform
-int platform_increment = 96;
-
-//Point for calculating the next platform location
-Point platform_spawn;
-
-//Array containing the possible widths for platforms
-int platform_widths[11] = {100, 110, 120, 130, 140, 150, 160, 170, 180, 190, 200};
-
-//Helper for calculating the next width
-int next_width;
-
-//How many pixels to offset the background when drawing
-int bg_offset = 0;
-
-//int for fading in the game over screen
-int game_over_fade = 0;
-int game_over_fade_2 = 0;
-
-//Probability of a pickup being spawned
-int coin_chance;
-
-int star_chance;
-
-//True when the user chooses to submit highscore
-bool submit_score = false;
+//Number of simulation steps dropped because we fell too far behind
+int skips = 0;
 
-//True after a name has been entered
-bool name_entered = false;
+//Length of one simulation step in seconds
+const double step_time = 1.0 / FPS;
 
-//The current letter to change in the highscore name
-int submit_selection = 0;
+//Most steps we'll run in one frame to catch up before giving up and letting the game slow down
+const int max_steps_per_frame = 5;
 
-//Character selection for name
-int score_name[] = {0,0,0};
+//Time that has passed but hasn't been simulated yet, and when we last checked
+double accumulator = 0;
+double last_time = 0;
 
-//Number of stars collected
-int stars = 0;
+//Positions to draw things at, the simulation moves in whole steps but we can draw in between them
+struct View
+{
+  float player_x;
+  float player_y;
+  float cam_x;
+  float cam_y;
+};
 
-bool allow_double_jump = false;
+//Anything that moves further than this in one step has been teleported, so don't draw it sliding across
+const float max_blend_distance = 100;
 
-bool has_double_jumped = false;
+//The view after the second last and the last step, and the one being drawn
+View last_view;
+View next_view;
+View view;
 
-int menu_selection = 0;
+//The allegro_display
+ALLEGRO_DISPLAY *display = NULL;
 
-bool play_song = false;
-bool play_death = true;
\ No newline at end of file
+//Every asset comes out of this if it's there, see pack.h
+Pack pack = {NULL, 0, 0, NULL};
+
+//Shown while the rest of the assets load in the background
+ALLEGRO_BITMAP *load_bitmap = NULL;
+
+//True once there's enough loaded to draw the menu, and once everything has loaded and the game can start
+bool menu_loaded = false;
+bool loaded = false;
+
+//Every piece of text drawn outside the profiler, each is only rendered again when it changes. See textcache.h
+enum CACHED_TEXTS
+{
+  TEXT_START,
+  TEXT_INSTRUCTIONS,
+  TEXT_LEADERBOARD,
+  TEXT_EXIT,
+  TEXT_SCORE,
+  TEXT_STARS,
+  TEXT_TIMES, //The x between the star and how many there are
+  TEXT_PAUSED,
+  TEXT_GAME_OVER,
+  TEXT_DISTANCE_LABEL,
+  TEXT_DISTANCE,
+  TEXT_COINS_LABEL,
+  TEXT_COINS,
+  TEXT_TOTAL_LABEL,
+  TEXT_TOTAL,
+  TEXT_SUBMIT,
+  TEXT_AGAIN,
+  TEXT_SCORES_TITLE,
+  TEXT_SCORES_EMPTY, //Loading or no scores yet
+  TEXT_SCORES_BACK,
+  num_cached_texts
+};
+
+CachedText texts[num_cached_texts];
+
+//The top of the leaderboard as it was last read, only read again when ScoresVersion changes. See leaderboard.h
+const int shown_scores = 10;
+ScoreEntry top_scores[shown_scores];
+int num_top_scores = 0;
+unsigned int top_scores_version = 0;
+
+//Rank and name, and score, for each row of the leaderboard
+CachedText score_names[shown_scores];
+CachedText score_values[shown_scores];
+
+//The background is scrolled by wrapping its texture round rather than moving the bitmap, see DrawBackground.
+//Each layer is one image moving speed pixels for every pixel the camera does, under 1 looks further away, drawn back to front.
+//The images are cut down to period rows when they're loaded, the pattern has to repeat every that many
+struct BackgroundLayer
+{
+  int image;
+  float speed;
+  int period;
+};
+
+const BackgroundLayer background_layers[] =
+{
+  {5, 1, 32}
+};
+
+const int num_background_layers = sizeof(background_layers) / sizeof(background_layers[0]);
+
+//The camera bitmap, everything in the game is drawn to this and then to the back buffer
+ALLEGRO_BITMAP *cam_screen = NULL;
+
+//The game as it was drawn when it was paused or ended. Nothing moves until it carries on, so after the first frame
+//this is drawn instead of the whole scene and only the pause or game over screen goes on top
+ALLEGRO_BITMAP *freeze_frame = NULL;
+bool freeze_frame_taken = false;
+
+//Everything drawn over the frozen game. While it's frozen the screen is only drawn again when some of this changes
+struct Overlay
+{
+  int state;
+  bool paused;
+  bool game_over;
+  bool submit_score;
+  bool name_entered;
+  int fade;
+  int submit_selection;
+  int score_name[3];
+};
+
+//What was on the overlay last time the screen was drawn
+Overlay drawn_overlay;
+
+//The platform image tiled across the width of the screen, platforms draw the part of it as wide as they are
+const int platform_strip_width = WIDTH;
+ALLEGRO_BITMAP *platform_strip = NULL;
+
+//Writes the input for every tick to a file when the game is started with -record
+ReplayRecorder recorder = {NULL, 0, 0, 0};
+
+//Input comes from here instead of the keyboard while replaying, when the game is started with -replay
+ReplayPlayer replay = {NULL, 0, 0, 0, 0, 0};
+bool replaying = false;
+
+//Plays instead of the keyboard when the game is started with -bot, see bot.h. After replays, which win if both are given
+Bot bot;
+bool bot_playing = false;
+
+//Where F5 saves the game to and F9 loads it back from, see snapshot.h
+const char *quicksave_path = "quicksave.tcss";
+
+//Saved every autosave_ticks steps of play and removed on a clean exit, if it's still there the game didn't close properly
+const char *autosave_path = "autosave.tcss";
+const int autosave_ticks = FPS * 10;
+int autosave_countdown = autosave_ticks;
+
+//Holds the snapshot being saved or loaded, a Game is too big to want on the stack
+Snapshot snapshot;
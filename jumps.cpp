@@ -0,0 +1,165 @@
+#include <cstddef>
+
+#include "jumps.h"
+
+//Sets the input for the next UpdatePlayer the same way StepGame does
+static void SetKeys(Game &game, unsigned int keys)
+{
+  game.old_keys = game.keys;
+  game.keys = keys;
+  game.num_events = 0;
+}
+
+//Jumps from standing in the middle of an empty screen at speed, holding right the whole way and jumping again on
+//tick second if it's above 0. Records the arc, and how far right the player got after each tick in reach if it's given
+static void RunJump(const Game &game, float speed, int second, JumpArc &arc, int *reach, int wrap)
+{
+  Game empty = game;
+  Player &player = empty.player;
+
+  InitPlayer(empty);
+
+  empty.num_platforms = 0;
+  empty.num_pickups = 0;
+  empty.num_enemies = 0;
+  empty.stars = 1;
+  empty.allow_double_jump = false;
+  empty.has_double_jumped = false;
+  empty.keys = 0;
+
+  player.x = WIDTH / 2;
+  player.y = 0;
+  player.state = player.WALKING;
+  player.speed = speed;
+  player.y_velocity = 0;
+
+  int feet = player.y + player.height * player.scale_y;
+  int x = player.x;
+  int moved = 0;
+
+  for (int t = 0; t < max_jump_ticks; ++t)
+  {
+    bool jumping = player.state == player.JUMPING;
+    unsigned int keys = 1u << RIGHT;
+
+    if (t == 0 || t == second)
+      keys |= 1u << UP;
+
+    SetKeys(empty, keys);
+    UpdatePlayer(empty);
+
+    //Landing is tested before the second jump takes off, with the state the player was in before it
+    arc.can_land[t] = t == second ? !jumping : player.state != player.JUMPING;
+    arc.rise[t] = feet - player.bottom_left.y;
+
+    //Going off one side puts the player on the other, count that as the pixels it really moved
+    int step = player.x - x;
+
+    if (step < -WIDTH / 2)
+      step += wrap;
+    else if (step > WIDTH / 2)
+      step -= wrap;
+
+    moved += step;
+    x = player.x;
+
+    if (reach)
+      reach[t] = moved;
+  }
+
+  arc.ticks = second > 0 && !empty.has_double_jumped ? 0 : max_jump_ticks;
+}
+
+void MeasureJumps(const Game &game, Jumps &jumps)
+{
+  const Player &player = game.player;
+  JumpArc running;
+
+  jumps.width = player.width * player.scale_x;
+  jumps.wrap = WIDTH + jumps.width;
+
+  RunJump(game, 0, 0, jumps.single, jumps.standing_reach, jumps.wrap);
+  RunJump(game, player.max_speed, 0, running, jumps.running_reach, jumps.wrap);
+
+  jumps.doubled[0].ticks = 0;
+
+  for (int n = 1; n < max_jump_ticks; ++n)
+    RunJump(game, player.max_speed, n, jumps.doubled[n], NULL, jumps.wrap);
+}
+
+//How far the player has to move sideways to get from anywhere between from_left and from_right to standing on to,
+//the shorter way round. Standing on a platform is anywhere from the player's right edge on its left end to their
+//left edge on its right end
+static int Distance(const Jumps &jumps, int from_left, int from_right, const Rect &to)
+{
+  int best = -1;
+
+  for (int around = -1; around <= 1; ++around)
+  {
+    int to_left = to.top_left.x - jumps.width + around * jumps.wrap;
+    int to_right = to.bottom_right.x + around * jumps.wrap;
+    int gap = 0;
+
+    if (to_left > from_right)
+      gap = to_left - from_right;
+    else if (from_left > to_right)
+      gap = from_left - to_right;
+
+    if (best < 0 || gap < best)
+      best = gap;
+  }
+
+  return best;
+}
+
+//True if some tick of arc has the feet inside a platform rise above the start and depth deep, within reach sideways.
+//That's when PlayerCollidePlatforms puts the player on top of it
+static bool CanLand(const JumpArc &arc, const int *reach, int distance, int rise, int depth)
+{
+  for (int t = 0; t < arc.ticks; ++t)
+  {
+    if (arc.can_land[t] && arc.rise[t] <= rise && arc.rise[t] >= rise - depth && reach[t] >= distance)
+      return true;
+  }
+
+  return false;
+}
+
+int JumpNeeds(const Jumps &jumps, const Rect &from, const Rect &to)
+{
+  int distance = Distance(jumps, from.top_left.x - jumps.width, from.bottom_right.x, to);
+  int rise = from.top_left.y - to.top_left.y;
+  int depth = to.bottom_right.y - to.top_left.y;
+
+  if (CanLand(jumps.single, jumps.standing_reach, distance, rise, depth))
+    return JUMP_STANDING;
+
+  if (CanLand(jumps.single, jumps.running_reach, distance, rise, depth))
+    return JUMP_RUNNING;
+
+  for (int n = 1; n < max_jump_ticks; ++n)
+  {
+    if (CanLand(jumps.doubled[n], jumps.running_reach, distance, rise, depth))
+      return JUMP_DOUBLE;
+  }
+
+  return JUMP_IMPOSSIBLE;
+}
+
+int PlanJump(const Jumps &jumps, int x, const Rect &from, const Rect &to)
+{
+  int distance = Distance(jumps, x, x, to);
+  int rise = from.top_left.y - to.top_left.y;
+  int depth = to.bottom_right.y - to.top_left.y;
+
+  if (CanLand(jumps.single, jumps.standing_reach, distance, rise, depth))
+    return 0;
+
+  for (int n = 1; n < max_jump_ticks; ++n)
+  {
+    if (CanLand(jumps.doubled[n], jumps.standing_reach, distance, rise, depth))
+      return n;
+  }
+
+  return -1;
+}
@@ -0,0 +1,55 @@
+//What the player can jump to. The arcs are measured by running UpdatePlayer itself on a copy of the game with
+//nothing else in it, so they follow every quirk of the real movement and change with it without anyone having
+//to keep a second copy of the physics up to date.
+//
+//Sideways the player comes back round to the same place after wrap pixels, UpdatePlayer moves them from just off
+//one side of the screen to just off the other. How far apart two platforms are is the shorter of the two ways round.
+
+#ifndef JUMPS_H
+#define JUMPS_H
+
+#include "simulation.h"
+
+//Longest jump measured, long enough to fall back past the start from the top of a double jump
+const int max_jump_ticks = 120;
+
+//One way of jumping, how high the player's feet are above where they started after each tick
+struct JumpArc
+{
+  int ticks; //0 if this arc can't happen
+  int rise[max_jump_ticks];
+  bool can_land[max_jump_ticks]; //False while UpdatePlayer won't let the player land, on the way up
+};
+
+struct Jumps
+{
+  JumpArc single; //Jump once and hold a direction
+  JumpArc doubled[max_jump_ticks]; //Jump again with a star on tick n of the first jump
+
+  //Furthest the player can get sideways after each tick holding a direction, from standing still and from full speed
+  int standing_reach[max_jump_ticks];
+  int running_reach[max_jump_ticks];
+
+  int width; //Of the player
+  int wrap;
+};
+
+//The easiest way a jump can be made, in order of difficulty
+enum JUMP_NEEDS
+{
+  JUMP_STANDING, //Straight from standing still
+  JUMP_RUNNING, //Only with a run up
+  JUMP_DOUBLE, //Only with a star for a double jump
+  JUMP_IMPOSSIBLE
+};
+
+void MeasureJumps(const Game &game, Jumps &jumps); //Measures the jumps of the player in game, as InitPlayer sets them up
+
+//Returns how the player can get from standing on platform from to landing on platform to, one of JUMP_NEEDS
+int JumpNeeds(const Jumps &jumps, const Rect &from, const Rect &to);
+
+//For a jump from standing still at x on platform from, returns 0 if one jump lands on to, the tick of the first jump
+//to jump again on if it takes two, or -1 if it can't be made from there
+int PlanJump(const Jumps &jumps, int x, const Rect &from, const Rect &to);
+
+#endif
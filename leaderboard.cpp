@@ -0,0 +1,387 @@
+#include <atomic>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "files.h"
+#include "leaderboard.h"
+#include "trace.h"
+
+using namespace std;
+
+//Best score first, the one that got there first wins a tie
+struct ScoreOrder
+{
+  bool operator()(const ScoreEntry &a, const ScoreEntry &b) const
+  {
+    if (a.score != b.score)
+      return a.score > b.score;
+
+    return a.sequence < b.sequence;
+  }
+};
+
+static multiset<ScoreEntry, ScoreOrder> scores;
+
+static string table_path;
+static string journal_path;
+
+//Open for appending once loading has finished, NULL if it couldn't be opened
+static FILE *journal = NULL;
+
+static unsigned int next_sequence = 1;
+static unsigned int version = 0;
+
+static thread worker;
+static atomic<bool> loaded(false);
+
+//Scores added but not in the journal yet. The writer appends and syncs them so the main thread never waits on the
+//disk, taking everything that's built up each time it wakes
+static thread writer;
+static mutex pending_lock;
+static condition_variable wake;
+static vector<ScoreEntry> pending; //Only touched with pending_lock held
+static bool closing = false; //Ditto
+static atomic<bool> write_failed(false);
+
+static void PutU32(unsigned char *data, unsigned int value)
+{
+  data[0] = value & 0xff;
+  data[1] = (value >> 8) & 0xff;
+  data[2] = (value >> 16) & 0xff;
+  data[3] = (value >> 24) & 0xff;
+}
+
+static unsigned int GetU32(const unsigned char *data)
+{
+  return (unsigned int)data[0] | ((unsigned int)data[1] << 8) | ((unsigned int)data[2] << 16) | ((unsigned int)data[3] << 24);
+}
+
+static void EncodeScore(const ScoreEntry &entry, unsigned char *record)
+{
+  PutU32(record, entry.sequence);
+  PutU32(record + 4, entry.score);
+  PutU32(record + 8, entry.when);
+  memcpy(record + 12, entry.name, 3);
+  record[15] = 0;
+  PutU32(record + 16, Checksum(record, 16));
+}
+
+//Returns false if the record fails its check
+static bool DecodeScore(const unsigned char *record, ScoreEntry &entry)
+{
+  if (GetU32(record + 16) != Checksum(record, 16))
+    return false;
+
+  entry.sequence = GetU32(record);
+  entry.score = GetU32(record + 4);
+  entry.when = GetU32(record + 8);
+  memcpy(entry.name, record + 12, 3);
+  entry.name[3] = '\0';
+
+  return true;
+}
+
+//Reads the whole of path in to contents, returns false if it isn't there
+static bool ReadFile(const string &path, vector<unsigned char> &contents)
+{
+  FILE *file = fopen(path.c_str(), "rb");
+
+  if (!file)
+    return false;
+
+  fseek(file, 0, SEEK_END);
+  long size = ftell(file);
+  fseek(file, 0, SEEK_SET);
+
+  contents.resize(size > 0 ? size : 0);
+  bool ok = size >= 0 && fread(contents.data(), 1, contents.size(), file) == contents.size();
+
+  fclose(file);
+  return ok;
+}
+
+//Reads the table in to scores and sets sequence to the last one in it.
+//Returns false if it's there but broken, in which case it mustn't be written over
+static bool ReadTable(unsigned int &sequence)
+{
+  vector<unsigned char> contents;
+
+  sequence = 0;
+
+  if (!ReadFile(table_path, contents))
+    return true;
+
+  const unsigned char *data = contents.data();
+
+  if (contents.size() < 16 || memcmp(data, "TCLB", 4) != 0 ||
+      (data[4] | (data[5] << 8)) != leaderboard_version || (data[6] | (data[7] << 8)) != score_record_size)
+    return false;
+
+  unsigned int count = GetU32(data + 8);
+  sequence = GetU32(data + 12);
+
+  if ((contents.size() - 16) / score_record_size < count)
+    return false;
+
+  //Already in order, so each one goes on the end without searching
+  for (unsigned int i = 0; i < count; ++i)
+  {
+    ScoreEntry entry;
+
+    if (!DecodeScore(data + 16 + i * score_record_size, entry))
+      return false;
+
+    scores.insert(scores.end(), entry);
+  }
+
+  return true;
+}
+
+//Adds every record in the journal after sequence, returns true if there was anything in it at all.
+//good is set to how long it is up to the end of the last whole record
+static bool ReadJournal(unsigned int sequence, long &good)
+{
+  vector<unsigned char> contents;
+
+  good = 0;
+
+  if (!ReadFile(journal_path, contents))
+    return false;
+
+  for (size_t offset = 0; offset + score_record_size <= contents.size(); offset += score_record_size)
+  {
+    ScoreEntry entry;
+
+    //Torn by a power cut, nothing after it can be trusted
+    if (!DecodeScore(contents.data() + offset, entry))
+      break;
+
+    if (entry.sequence > sequence)
+      scores.insert(entry);
+
+    good = offset + score_record_size;
+  }
+
+
+  //Even a record that was never finished needs clearing out, or everything added after it would be lost too
+  return !contents.empty();
+}
+
+//Writes every score to a new table and renames it over the old one
+static bool WriteTable()
+{
+  string temp_path = table_path + ".new";
+  FILE *file = fopen(temp_path.c_str(), "wb");
+
+  if (!file)
+    return false;
+
+  unsigned char header[16];
+  memcpy(header, "TCLB", 4);
+  header[4] = leaderboard_version & 0xff;
+  header[5] = (leaderboard_version >> 8) & 0xff;
+  header[6] = score_record_size & 0xff;
+  header[7] = (score_record_size >> 8) & 0xff;
+  PutU32(header + 8, scores.size());
+  PutU32(header + 12, next_sequence - 1);
+
+  bool ok = fwrite(header, 1, sizeof(header), file) == sizeof(header);
+
+  for (multiset<ScoreEntry, ScoreOrder>::const_iterator i = scores.begin(); ok && i != scores.end(); ++i)
+  {
+    unsigned char record[score_record_size];
+    EncodeScore(*i, record);
+    ok = fwrite(record, 1, score_record_size, file) == (size_t)score_record_size;
+  }
+
+  ok = SyncFile(file) && ok;
+  ok = fclose(file) == 0 && ok;
+
+  if (!ok || !RenameOver(temp_path.c_str(), table_path.c_str(), true))
+  {
+    remove(temp_path.c_str());
+    return false;
+  }
+
+  return true;
+}
+
+static void LoadScores()
+{
+  TRACE_SCOPE("LoadScores");
+
+  unsigned int sequence;
+  bool table_ok = ReadTable(sequence);
+  long journal_good;
+  bool journal_used = ReadJournal(sequence, journal_good);
+
+  next_sequence = sequence + 1;
+
+  for (multiset<ScoreEntry, ScoreOrder>::const_iterator i = scores.begin(); i != scores.end(); ++i)
+  {
+    if (i->sequence >= next_sequence)
+      next_sequence = i->sequence + 1;
+  }
+
+  //Fold the journal in to the table, once the new table is safely down the journal can start again empty.
+  //If the table is broken leave both alone for someone to look at rather than lose what's in it
+  bool empty_journal = false;
+
+  if (journal_used && table_ok && WriteTable())
+    empty_journal = true;
+
+  journal = fopen(journal_path.c_str(), empty_journal ? "wb" : "ab");
+
+  //A torn record left on the end would hide everything appended after it next time, so cut it off first. If that
+  //can't be done don't append at all
+  if (journal && !empty_journal && !TruncateFile(journal, journal_good))
+  {
+    fclose(journal);
+    journal = NULL;
+  }
+
+  ++version;
+
+  loaded.store(true, memory_order_release);
+}
+
+//Runs on the writer, appends whatever has been added to the journal until CloseScores
+static void WriteScores()
+{
+  unique_lock<mutex> lock(pending_lock);
+  vector<ScoreEntry> writing;
+
+  for (;;)
+  {
+    while (pending.empty() && !closing)
+      wake.wait(lock);
+
+    //Anything added before closing still gets written
+    if (pending.empty())
+      break;
+
+    writing.swap(pending);
+    lock.unlock();
+
+    {
+      TRACE_SCOPE("WriteScores");
+
+      bool ok = true;
+
+      for (size_t i = 0; i < writing.size() && ok; ++i)
+      {
+        unsigned char record[score_record_size];
+        EncodeScore(writing[i], record);
+        ok = fwrite(record, 1, score_record_size, journal) == (size_t)score_record_size;
+      }
+
+      //One sync covers everything that built up while the last one was going
+      if (!ok || !SyncFile(journal))
+        write_failed = true;
+    }
+
+    writing.clear();
+    lock.lock();
+  }
+}
+
+//Makes sure the worker has finished and it's safe to touch scores
+static void WaitForScores()
+{
+  if (worker.joinable())
+    worker.join();
+}
+
+void StartLoadingScores(const char *path)
+{
+  table_path = path;
+  journal_path = table_path + ".journal";
+
+  loaded = false;
+  closing = false;
+  write_failed = false;
+  worker = thread(LoadScores);
+  writer = thread(WriteScores);
+}
+
+bool ScoresLoaded()
+{
+  return loaded.load(memory_order_acquire);
+}
+
+bool AddScore(unsigned int score, const char *name, unsigned int when)
+{
+  WaitForScores();
+
+  ScoreEntry entry;
+  entry.sequence = next_sequence++;
+  entry.score = score;
+  entry.when = when;
+  strncpy(entry.name, name, 3);
+  entry.name[3] = '\0';
+
+  scores.insert(entry);
+  ++version;
+
+  if (!journal)
+    return false;
+
+  {
+    lock_guard<mutex> lock(pending_lock);
+    pending.push_back(entry);
+  }
+
+  wake.notify_one();
+  return !write_failed;
+}
+
+int TopScores(ScoreEntry *entries, int count)
+{
+  WaitForScores();
+
+  int found = 0;
+
+  for (multiset<ScoreEntry, ScoreOrder>::const_iterator i = scores.begin(); i != scores.end() && found < count; ++i)
+    entries[found++] = *i;
+
+  return found;
+}
+
+int CountScores()
+{
+  WaitForScores();
+
+  return scores.size();
+}
+
+unsigned int ScoresVersion()
+{
+  return version;
+}
+
+void CloseScores()
+{
+  WaitForScores();
+
+  if (writer.joinable())
+  {
+    {
+      lock_guard<mutex> lock(pending_lock);
+      closing = true;
+    }
+
+    wake.notify_one();
+    writer.join();
+  }
+
+  if (journal)
+    fclose(journal);
+
+  journal = NULL;
+}
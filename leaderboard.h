@@ -0,0 +1,49 @@
+//High score table kept on disk, every score ever submitted in score order.
+//Adding a score appends one record to a journal instead of rewriting the table, so it costs the same however many
+//there are. The journal is folded in to the table the next time it's loaded, by writing a new table next to the old
+//one and renaming it over the top, so a power cut at any point leaves either the old table or the new one.
+//Loading happens on another thread so it never holds up starting the game, and so does writing to the journal so
+//adding a score never waits on the disk.
+//
+//File formats, all little endian:
+//  table           "TCLB", u16 leaderboard_version, u16 score_record_size, u32 count, u32 sequence,
+//                  then count records in score order. sequence is the highest in the table, journal records
+//                  at or below it are already in it
+//  journal         just records, in the order they were added
+//  record          u32 sequence, u32 score, u32 when, 3 name chars, u8 pad, u32 check    check is over the 16 bytes before it,
+//                  a record torn by a power cut fails it and is ignored along with anything after it
+
+#ifndef LEADERBOARD_H
+#define LEADERBOARD_H
+
+const int leaderboard_version = 1;
+const int score_record_size = 20;
+
+struct ScoreEntry
+{
+  unsigned int sequence; //Order it was added in, earlier wins a tie
+  unsigned int score;
+  unsigned int when; //Seconds since 1970
+  char name[4]; //Three characters and a terminator
+};
+
+//Starts reading the table at path and its journal at path.journal on another thread, folding the journal in if it
+//has anything in it. A missing table is an empty one
+void StartLoadingScores(const char *path);
+
+bool ScoresLoaded(); //True once loading has finished, nothing below waits after this
+
+//Adds a score and hands it to another thread to write to the journal, waiting for loading first if it hasn't finished.
+//Returns false if the journal couldn't be opened or an earlier score couldn't be written, the score is still on
+//the table until the game closes
+bool AddScore(unsigned int score, const char *name, unsigned int when);
+
+int TopScores(ScoreEntry *entries, int count); //Copies out the best count scores, best first, returns how many there were
+int CountScores();
+
+//Goes up every time a score is added, so anything showing the scores knows when to look again
+unsigned int ScoresVersion();
+
+void CloseScores(); //Waits for loading and for every score added to be written, then closes the journal
+
+#endif
@@ -0,0 +1,96 @@
+#include <atomic>
+#include <cstring>
+#include <thread>
+
+#include <Allegro5\allegro.h>
+#include <Allegro5\allegro_font.h>
+#include <Allegro5\allegro_ttf.h>
+#include <Allegro5\allegro_audio.h>
+#include <Allegro5\allegro_memfile.h>
+
+#include "loader.h"
+#include "trace.h"
+
+using namespace std;
+
+static thread worker;
+
+//Written by the worker after each asset's data is set, so everything below it is safe to read
+static atomic<int> loaded(0);
+static atomic<bool> cancelled(false);
+
+static void LoadAssets(Asset *assets, int count, const Pack *pack)
+{
+  //New bitmap flags are per thread, so this doesn't affect the display thread
+  int flags = al_get_new_bitmap_flags();
+
+  for (int i = 0; i < count && !cancelled; ++i)
+  {
+    Asset &asset = assets[i];
+    TRACE_SCOPE(asset.path);
+
+    ALLEGRO_FILE *file = OpenAsset(pack, asset.path);
+    const char *extension = strrchr(asset.path, '.');
+
+    asset.data = NULL;
+
+    if (!file)
+    {
+      loaded.store(i + 1, memory_order_release);
+      continue;
+    }
+
+    switch (asset.type)
+    {
+    case ASSET_BITMAP:
+      //There's no display on this thread, the main thread uploads them
+      al_set_new_bitmap_flags(ALLEGRO_MEMORY_BITMAP);
+      asset.data = al_load_bitmap_f(file, extension);
+      al_fclose(file);
+      break;
+    case ASSET_FONT:
+      //Fonts keep the flags they were loaded with for the glyph textures they make when first drawn on the main thread.
+      //The font keeps the file and closes it when it's destroyed, or straight away if loading fails
+      al_set_new_bitmap_flags(flags);
+      asset.data = al_load_ttf_font_f(file, asset.path, asset.size, 0);
+      break;
+    case ASSET_SAMPLE:
+      asset.data = al_load_sample_f(file, extension);
+      al_fclose(file);
+      break;
+    }
+
+    loaded.store(i + 1, memory_order_release);
+  }
+}
+
+void StartLoading(Asset *assets, int count, const Pack *pack)
+{
+  loaded = 0;
+  cancelled = false;
+  worker = thread(LoadAssets, assets, count, pack);
+}
+
+int LoadedAssets()
+{
+  return loaded.load(memory_order_acquire);
+}
+
+void StopLoading()
+{
+  cancelled = true;
+
+  if (worker.joinable())
+    worker.join();
+}
+
+ALLEGRO_FILE *OpenAsset(const Pack *pack, const char *path)
+{
+  const void *data;
+  size_t size;
+
+  if (pack && pack->data && FindInPack(*pack, path, data, size))
+    return al_open_memfile((void *)data, size, "r");
+
+  return al_fopen(path, "rb");
+}
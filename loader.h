@@ -0,0 +1,38 @@
+//Loads the game's files on a background thread so the window can keep drawing while they come in.
+//The worker only decodes them in to memory, anything that needs the display, like uploading bitmaps to
+//the graphics card, is left for the main thread to do when it takes them.
+//Files come out of the asset pack if one is open and straight off the disk if not.
+
+#ifndef LOADER_H
+#define LOADER_H
+
+#include <Allegro5\allegro.h>
+
+#include "pack.h"
+
+enum ASSET_TYPES{ASSET_BITMAP, ASSET_FONT, ASSET_SAMPLE};
+
+//One file to load. The worker fills in data, an ALLEGRO_BITMAP, ALLEGRO_FONT or ALLEGRO_SAMPLE, NULL if it failed
+struct Asset
+{
+  int type;
+  const char *path;
+  int size; //Point size for fonts
+  int index; //Where it goes in images, fonts or sounds
+  void *data;
+};
+
+//Starts loading count assets in order on another thread, from pack unless it's NULL. assets and pack must stay alive
+//until StopLoading, and the pack until the fonts and the theme tune's stream are destroyed because they keep reading from it. Bitmaps are loaded as memory bitmaps
+void StartLoading(Asset *assets, int count, const Pack *pack);
+
+//Returns how many assets have been loaded, assets[0] up to this are safe to use
+int LoadedAssets();
+
+//Skips anything not started yet and waits for the thread to finish, safe to call more than once
+void StopLoading();
+
+//Opens path from pack if it's in there, or from the disk if not or pack is NULL
+ALLEGRO_FILE *OpenAsset(const Pack *pack, const char *path);
+
+#endif
@@ -1,4 +1,9 @@
 #include <iostream>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <cmath>
 
 #include <Allegro5\allegro.h>
 #include <Allegro5\allegro_primitives.h>
@@ -8,41 +13,50 @@
 #include <Allegro5\allegro_audio.h>
 #include <Allegro5\allegro_acodec.h>
 
-#include "objects.h"
+#include "simulation.h"
+#include "replay.h"
+#include "profiler.h"
+#include "pack.h"
+#include "textcache.h"
+#include "leaderboard.h"
+#include "scoreclient.h"
+#include "bot.h"
+#include "snapshot.h"
 #include "globals.h"
+#include "loader.h"
+#include "voices.h"
 #include "assets.h"
+#include "atlas.h"
 
 using namespace std;
 
 
-void Update(); //Update the current game state, once every frame
+void Advance(); //Runs as many simulation steps as real time has passed since the last frame
+void Update(); //Steps the simulation once and handles what it reports
+unsigned int KeyMask(); //Packs the keys that are down in to the input mask for the simulation
+void StartIdling(ALLEGRO_TIMER *timer); //Stops the timer until StopIdling, nothing is stepped or drawn in between
+void StopIdling(ALLEGRO_TIMER *timer); //Starts the timer again without trying to catch up on the time spent idle
 void Draw(); //Handles all of the drawing on screen, after Update
 void CheckKeys(ALLEGRO_EVENT &ev, bool pressed); //Checks the current up/down state of each key in the keys array
-
-bool JustPressed(int keycode); //Returns true if keycode has just been pressed this frame
-
-void InitCamera();
-
-void InitPlayer(); //Player constructor, initializes all the starting variables etc.
-void UpdatePlayer(); //Updates all player logic
-void DrawPlayer(); //Draws the player, also handles the animation
-void ChangePlayerAnimation(int animation, bool hard); //Changes the current animation, set hard to true to restart the animation
-
-void SpawnPlatform(int x, int y, int width, int height, int id); //Spawns a platform of width*height at x,y. Supply id for insertion or -1 for first available
-void UpdatePlatforms();
+void HandleEvents(); //Plays the sounds the last step asked for
+bool SaveGame(const char *path); //Writes a snapshot of the game to path, see snapshot.h
+bool LoadGame(const char *path); //Carries on from the snapshot at path, returns false and leaves the game alone if it can't be read
+View TakeView(); //Gets the positions to draw things at from the current game state
+View BlendView(const View &from, const View &to, float alpha); //Blends between two views, alpha 0 is from and 1 is to
+bool Frozen(); //True when the game is paused or over and nothing behind the overlay moves
+Overlay TakeOverlay(); //Gets everything that's drawn over the frozen game
+
+void DrawPlayer(); //Draws the player in its current animation frame
+
+void CreatePlatformStrip(); //Tiles the platform image in to one long strip that every platform is drawn from
+void CreateBackgroundTiles(); //Cuts each background layer's image down to one period so it can be wrapped
 void DrawPlatforms();
-void RemovePlatform(int id); //"kills" the platform at id in the array
-int PlayerCollidePlatforms(); //Returns the index of the platform being collided with or -1 if no collision.
-
-void SpawnPickup(int x, int y, int type); //Spawns a pickup of type at x,y
-void UpdatePickups(); //Updates the pickups
-void PlayerCollidePickups(); //Checks for collisions on all the pickups currently in play, calling CollectPickup if necessary
-void CollectPickup(int id); //To be called when a pickup is collected, takes actions depending on pickup
-void RemovePickup(int id); //Removes the pickup from play
+
 void DrawPickups(); //Draws the pickups to the screen
 
-void UpdateBackground(); //Updates the current background offset
-void DrawBackground(); //Draws the background
+void DrawEnemies(); //Draws the enemies walking or squashed
+
+void DrawBackground(); //Draws each background layer as one quad, scrolled by where the camera is
 
 void DrawHUD(); //Draw the HUD
 
@@ -50,28 +64,82 @@ void DrawPauseScreen(); //Draws the pause screen
 
 void DrawGameOverScreen(); //Draws the game over screen
 
-int Rand(int limit);
+void DrawLeaderboard(); //Draws the best scores saved so far
 
-void NewGame(); //Re-initializes everything for a new game
+void DrawProfiler(); //Draws the profiler overlay, toggled with F1
+
+void TakeAssets(); //Takes whatever the loader has finished since last time and puts it where it belongs, sets done if any failed
+void FinishLoading(); //Builds the atlas and sets up the theme tune and sound voices once everything is in
+void DrawLoading(); //Draws the loading screen
+void DrawLoadingBar(int y); //Draws how far through loading we are, with a bit that moves so it's obviously still going
 
 void Destroy(); //Destroy everything when closing
 
 //Objects
-Player player; //The player object
-Platform platforms[max_platforms]; //Array containing all of the platforms
-Pickup pickups[max_pickups]; //Array containing all the pickups
-Camera cam; //The camera object for rendering the correct part of the screen
+Game game; //All of the game state, see simulation.h
 
-int main(void)
+int main(int argc, char **argv)
 {
   //Allegro variables
   ALLEGRO_EVENT_QUEUE *event_queue = NULL;
   ALLEGRO_TIMER *timer = NULL;
 
+  unsigned int seed = (unsigned int)time(NULL);
+  const char *record_path = NULL;
+  const char *replay_path = NULL;
+  const char *profile_path = NULL;
+  const char *scores_address = NULL;
+  const char *restore_path = NULL;
+
+  //Command line options
+  for (int i = 1; i < argc; ++i)
+  {
+    if (strcmp(argv[i], "-seed") == 0 && i + 1 < argc)
+      seed = (unsigned int)strtoul(argv[++i], NULL, 10);
+    else if (strcmp(argv[i], "-record") == 0 && i + 1 < argc)
+      record_path = argv[++i];
+    else if (strcmp(argv[i], "-replay") == 0 && i + 1 < argc)
+      replay_path = argv[++i];
+    else if (strcmp(argv[i], "-profile") == 0 && i + 1 < argc)
+      profile_path = argv[++i];
+    else if (strcmp(argv[i], "-hitch") == 0 && i + 1 < argc)
+      hitch_time = atof(argv[++i]);
+    else if (strcmp(argv[i], "-trace") == 0)
+      tracing = true;
+    else if (strcmp(argv[i], "-scores") == 0 && i + 1 < argc)
+      scores_address = argv[++i];
+    else if (strcmp(argv[i], "-bot") == 0)
+      bot_playing = true;
+    else if (strcmp(argv[i], "-restore") == 0 && i + 1 < argc)
+      restore_path = argv[++i];
+  }
+
+  //Both cost a clock read or two for every timed section, so they're only on when something is going to look.
+  //A hitch can only be written out if the trace was already recording
+  profile_run = profile_path != NULL;
+  profiling = profile_run;
+  tracing = tracing || hitch_time > 0;
+
+  if (replay_path)
+  {
+    if (!StartPlayback(replay, replay_path))
+    {
+      cerr << "Couldn't read replay " << replay_path << endl;
+      return -1;
+    }
+
+    replaying = true;
+    seed = replay.seed;
+  }
+
+  if (record_path && !StartRecording(recorder, record_path, seed))
+    cerr << "Couldn't open " << record_path << " for recording" << endl;
+
   //Initialization Functions
   if(!al_init())										//initialize Allegro
     return -1;
 
+  al_set_new_display_option(ALLEGRO_VSYNC, 1, ALLEGRO_SUGGEST);
   display = al_create_display(WIDTH, HEIGHT);			//create our display object
 
   if(!display)										//test display object
@@ -86,53 +154,59 @@ int main(void)
   al_install_audio();
   al_init_acodec_addon();
 
-  ALLEGRO_BITMAP *load_bitmap = al_load_bitmap("Assets/Images/Loading.png");
-  al_clear_to_color(al_map_rgb(0,0,0));
-  al_draw_bitmap(load_bitmap, (WIDTH / 2) - 125, 250, 0);
-  al_flip_display();
+  //One file to open instead of one per asset, if it's missing they're loaded one by one from Assets/ instead
+  if (!OpenPack(pack, "assets.pack"))
+    cerr << "No assets.pack, loading assets from separate files" << endl;
 
-  al_destroy_bitmap(load_bitmap);
+  //Nothing needs the high scores until a game ends or they're looked at, so they load alongside everything else
+  StartLoadingScores("scores.dat");
+
+  //host:port or host:port/path
+  if (scores_address)
+  {
+    string address = scores_address;
+    size_t colon = address.find(':');
+    size_t slash = address.find('/');
+
+    if (colon == string::npos || (slash != string::npos && slash < colon))
+      cerr << "-scores wants host:port, not " << scores_address << endl;
+    else
+      sending_scores = StartScoreClient(address.substr(0, colon).c_str(), address.substr(colon + 1, slash - colon - 1).c_str(),
+                                        slash == string::npos ? "/scores" : address.substr(slash).c_str(), "scores.spool");
+  }
+
+  //The loading screen is drawn every frame until everything else has come in
+  ALLEGRO_FILE *load_file = OpenAsset(&pack, "Assets/Images/Loading.png");
+
+  if (load_file)
+  {
+    load_bitmap = al_load_bitmap_f(load_file, ".png");
+    al_fclose(load_file);
+  }
 
 
   al_set_window_title(display, "TowerClimb");
 
   event_queue = al_create_event_queue();
-  timer = al_create_timer(1.0 / FPS);
-
-  //Load images
-  images[0] = al_load_bitmap("Assets/Images/Mario-Stand.png");
-  images[1] = al_load_bitmap("Assets/Images/Mario-Run.png");
-  images[2] = al_load_bitmap("Assets/Images/Mario-Skid.png");
-  images[3] = al_load_bitmap("Assets/Images/Mario-Jump.png");
-  images[4] = al_load_bitmap("Assets/Images/Platform2.png");
-  images[5] = al_load_bitmap("Assets/Images/Background.png");
-  images[6] = al_load_bitmap("Assets/Images/Coin.png");
-  images[7] = al_load_bitmap("Assets/Images/Heart.png");
-  images[8] = al_load_bitmap("Assets/Images/Pause.png");
-  images[9] = al_load_bitmap("Assets/Images/Star.png");
-  images[10] = al_load_bitmap("Assets/Images/Instructions.png");
-  images[11] = al_load_bitmap("Assets/Images/Title.png");
-  
-  //Load fonts
-  fonts[0] = al_load_font("Assets/Fonts/arial.ttf", 16, 0);
-  fonts[1] = al_load_font("Assets/Fonts/big_noodle_titling.ttf", 28, 0);
-  fonts[2] = al_load_font("Assets/Fonts/big_noodle_titling.ttf", 42, 0);
-  fonts[3] = al_load_font("Assets/Fonts/big_noodle_titling.ttf", 58, 0);
-  fonts[4] = al_load_font("Assets/Fonts/big_noodle_titling.ttf", 20, 0);
-
-  //Load sounds
-  al_reserve_samples(10);
-  sounds[0] = al_load_sample("Assets/Audio/coin.wav");
-  sounds[1] = al_load_sample("Assets/Audio/star.wav");
-  sounds[2] = al_load_sample("Assets/Audio/mariodie.wav");
-  sounds[3] = al_load_sample("Assets/Audio/jump.wav");
-  sounds[4] = al_load_sample("Assets/Audio/doublejump.wav");
-  sounds[5] = al_load_sample("Assets/Audio/pause.wav");
-  sounds[6] = al_load_sample("Assets/Audio/song.ogg");
-  song_instance = al_create_sample_instance(sounds[6]);
-  al_set_sample_instance_playmode(song_instance, ALLEGRO_PLAYMODE_LOOP);
-  al_attach_sample_instance_to_mixer(song_instance, al_get_default_mixer());
 
+  //The timer paces drawing, at the rate of the monitor if we can find out what it is.
+  //The simulation always runs at FPS steps a second however quickly we draw
+  int refresh_rate = al_get_display_refresh_rate(display);
+
+  if (refresh_rate <= 0)
+    refresh_rate = FPS;
+
+  timer = al_create_timer(1.0 / refresh_rate);
+
+  //Sound effects have their own voices, see voices.h, this just sets up the default mixer they and the theme tune play through
+  al_reserve_samples(0);
+
+  //Everything else loads in the background, see TakeAssets
+  StartLoading(assets, num_assets, &pack);
+
+  //Bitmaps we draw in to, these live for the whole run
+  cam_screen = al_create_bitmap(WIDTH, HEIGHT);
+  freeze_frame = al_create_bitmap(WIDTH, HEIGHT);
 
 
   al_register_event_source(event_queue, al_get_keyboard_event_source());
@@ -140,1161 +214,1207 @@ int main(void)
   al_register_event_source(event_queue, al_get_timer_event_source(timer));
 
   al_start_timer(timer);
+  run_start = al_get_time();
+
+  TakeAssets();
+
+  InitGame(game, seed);
+  InitBot(bot, game);
+
+  if (restore_path && !LoadGame(restore_path))
+    cerr << "Couldn't restore " << restore_path << ", it's missing, damaged or from a different build" << endl;
+
+  //Only a crash leaves it behind, say so rather than carry on from it without being asked
+  if (!restore_path)
+  {
+    FILE *autosave = fopen(autosave_path, "rb");
 
-  NewGame();
+    if (autosave)
+    {
+      fclose(autosave);
+      cerr << "The last game didn't close properly, start with -restore " << autosave_path << " to carry on from it" << endl;
+    }
+  }
+
+  HandleEvents();
+
+  last_view = next_view = TakeView();
+  last_time = al_get_time();
 
   while(!done)
   {
     ALLEGRO_EVENT ev;
-    al_wait_for_event(event_queue, &ev);
+
+    {
+      TRACE_SCOPE("Wait");
+      al_wait_for_event(event_queue, &ev);
+    }
 
     switch(ev.type)
     {
     case ALLEGRO_EVENT_DISPLAY_CLOSE:
       done = true;
       break;
+    case ALLEGRO_EVENT_DISPLAY_EXPOSE:
+    case ALLEGRO_EVENT_DISPLAY_SWITCH_IN:
+      //Whatever was on screen may have been lost while it was frozen and not drawing
+      StopIdling(timer);
+      redraw = true;
+      break;
     case ALLEGRO_EVENT_KEY_DOWN:
+      StopIdling(timer);
       CheckKeys(ev, true);
       break;
     case ALLEGRO_EVENT_KEY_UP:
+      StopIdling(timer);
       CheckKeys(ev, false);
       break;
     case ALLEGRO_EVENT_TIMER:
-      Update();
+      if (!loaded)
+      {
+        TakeAssets();
+
+        if (done)
+          break;
+
+        if (assets_taken == num_assets)
+          FinishLoading();
+      }
+
+      Advance();
+
+      //On the menu, instructions or paused and nothing's been pressed, so there's nothing to do until something is.
+      //Steps skipped here would have changed nothing, so recordings still replay the same.
+      //Replays keep going, and so does the profiler overlay so it stays up to date
+      if (loaded && !replaying && !bot_playing && !show_profiler && GameIdle(game) && KeyMask() == game.keys &&
+          (game.current_state != LEADERBOARD || ScoresLoaded()))
+        StartIdling(timer);
       break;
     }
-    
-    if(redraw && al_is_event_queue_empty(event_queue))
+
+    if(redraw && !done && al_is_event_queue_empty(event_queue))
     {
       redraw = false;
       Draw();
     }
   }
 
+  StopRecording(recorder);
+  StopPlayback(replay);
+
+  if (profile_path && !WriteProfileCSV(profile_path))
+    cerr << "Couldn't write profile to " << profile_path << endl;
+
+  //How much the machine was kept busy, to compare against a run without idling
+  if (profile_path)
+  {
+    double run_time = al_get_time() - run_start;
+
+    StopIdling(timer);
+
+    if (run_time > 0)
+      printf("Ran for %.1fs, %.1f%% of it idle. CPU %.1f%% of one core, %lld frames drawn, %.1f a second\n", run_time,
+             100 * idle_time / run_time, 100 * ProcessCpuTime() / run_time, frames_drawn, frames_drawn / run_time);
+
+    if (sending_scores)
+    {
+      ScoreClientStats score_stats = GetScoreClientStats();
+      printf("Scores sent %lld, still queued %i, dropped %lld, failed requests %lld, latency avg %.1fms\n",
+             score_stats.sent, score_stats.queued, score_stats.dropped, score_stats.failures, score_stats.avg_latency);
+    }
+  }
+
+  if (bot_playing && bot.stats.games > 0)
+    printf("Bot played %i games, best climb %i pixels, average %.0f\n", bot.stats.games, bot.stats.best_climb,
+           (double)bot.stats.total_climb / bot.stats.games);
+
+  //Closed properly, so there's nothing to recover next time
+  remove(autosave_path);
+
+  //Gives up on anything it's sending after a few seconds at most, what's left goes next time
+  StopScoreClient();
+
+  WaitForTraceWrites();
+
   al_destroy_event_queue(event_queue);
   al_destroy_timer(timer);
   al_destroy_display(display);
   Destroy();
 
+  //The fonts read from the pack right up until they're destroyed
+  ClosePack(pack);
+
   return 0;
 }
 
-void Update()
+void Advance()
 {
-  if (current_state == GAME)
-  {
-    if (new_game)
-    {
-      NewGame();
-    }
+  double now = al_get_time();
+  int steps = 0;
 
-    if (!game_over)
-    {
-      if (!paused)
-      {
-        if (play_song)
-        {
-          al_play_sample_instance(song_instance);
-          play_song = false;
-        }
-
-        UpdateBackground();
-        UpdatePlatforms();
-        UpdatePickups();
-        UpdatePlayer();
-
-        //Save the state of the camera to help with the fake background scrolling
-        cam.last.x = cam.x;
-        cam.last.y = cam.y;
-
-        if ((player.y + cam.y) < HEIGHT / 4 && scroll_speed < 3)
-          cam.y += 3;
-      
-        if (scrolling)//If the scrolling has started then move the cam by scroll_speed;
-        {
-          cam.y += scroll_speed;
-        }
-        else //Else if the player reaches the threshold start scrolling
-        {
-          if (player.y + cam.y < HEIGHT / 4)
-            scrolling = true;
-        }
-      
-        //Keeps track of the highest point the player has reached so far
-        if (highest < -(player.y - zero))
-          highest = -(player.y - zero);
-
-        //Checks to see if player has fallen off the bottom (game over)
-        if (player.y + cam.y > HEIGHT + 100)
-          player.health = 0;
-
-        if (player.health == 0)
-          game_over = true;
-
-        if (dificulty < max_dificulty)
-        {
-          dificulty = float(float(float(float(highest / 2)) / 1000) / 10) + 1;
-        }
-        else
-        {
-          dificulty = max_dificulty;
-        }
-
-        if (scroll_speed < max_scroll_speed)
-        {
-          scroll_speed = float(float(float(float(highest / 2)) / 1000) / 2) + 1;
-        }
-        else
-        {
-          scroll_speed = max_scroll_speed;
-        }
-
-        if (JustPressed(P))
-          paused = true;      
-      }
-      else //Game is paused, update pause screen
-      {
-        al_stop_sample_instance(song_instance);
+  //The simulation waits for everything to load, so the first step is always the same however long that takes
+  if (!loaded)
+  {
+    last_time = now;
+    redraw = true;
+    return;
+  }
 
-        if (JustPressed(P))
-        {
-          play_song = true;
-          paused = false;
-        }
-      }
-    }
-    else //Game Over!
-    {
-      al_stop_sample_instance(song_instance);
-      if (play_death)
-      {
-        al_play_sample(sounds[2], 1, 0, 1, ALLEGRO_PLAYMODE_ONCE, 0);
-        play_death = false;
-      }
+  accumulator += now - last_time;
+  last_time = now;
 
-      if (submit_score)
-      {
-        if (!name_entered)
-        {
-          if (JustPressed(LEFT))
-          {
-            if (submit_selection == 0)
-            {
-              submit_selection = 2;
-            }
-            else
-            {
-              --submit_selection;
-            }
-          }
-
-          if (JustPressed(RIGHT))
-          {
-            if (submit_selection == 2)
-            {
-              submit_selection = 0;
-            }
-            else
-            {
-              ++submit_selection;
-            }
-          }
-
-          if (JustPressed(UP))
-          {
-            if (score_name[submit_selection] == num_chars - 2)
-            {
-              score_name[submit_selection] = 0;
-            }
-            else
-            {
-              ++score_name[submit_selection];
-            }
-          }
-
-          if (JustPressed(DOWN))
-          {
-            if (score_name[submit_selection] == 0)
-            {
-              score_name[submit_selection] = num_chars - 2;
-            }
-            else
-            {
-              --score_name[submit_selection];
-            }
-          }
-
-          if (JustPressed(ENTER))
-            name_entered = true;
-        }
-        else //Name inputted, submit the score!
-        {
-          //TODO: Actually submit the score :P
-          new_game = true;
-        }
+  while (accumulator >= step_time && steps < max_steps_per_frame)
+  {
+    Update();
+    accumulator -= step_time;
+    ++steps;
+  }
 
-      }
-      else
-      {
-        /*if (JustPressed(S))
-          submit_score = true;*/
-      }
-    }
+  //Too far behind to catch up, drop the rest and let the game slow down rather than spiral
+  if (accumulator >= step_time)
+  {
+    skips += (int)(accumulator / step_time);
+    TraceInstant("Dropped steps");
+    accumulator = fmod(accumulator, step_time);
+  }
 
-    if (JustPressed(R))
-    {
-      new_game = true;
-    }
+  //Paused or game over, so there's only anything new to draw if the overlay has changed
+  if (!Frozen() || show_profiler)
+  {
+    redraw = true;
   }
-  else if (current_state == MENU)
+  else
   {
-    al_stop_sample_instance(song_instance);
+    Overlay overlay = TakeOverlay();
 
-    if (JustPressed(UP))
-    {
-      if (menu_selection == 0)
-      {
-        menu_selection = 2;
-      }
-      else
-      {
-        menu_selection--;
-      }
-    }
+    if (memcmp(&overlay, &drawn_overlay, sizeof(Overlay)) != 0)
+      redraw = true;
+  }
+}
+
+void Update()
+{
+  unsigned int input = 0;
 
-    if (JustPressed(DOWN))
+  if (replaying)
+  {
+    //Feed the recorded input back in, the keyboard takes over again once the replay runs out
+    if (!NextTick(replay, input))
     {
-      if (menu_selection == 2)
-      {
-        menu_selection = 0;
-      }
-      else
-      {
-        menu_selection++;
-      }
+      replaying = false;
+      StopPlayback(replay);
     }
+  }
 
-    if (JustPressed(ENTER))
+  if (!replaying && bot_playing)
+  {
+    int games_before = bot.stats.games;
+    input = BotInput(bot, game);
+
+    //Frame times are over the last profile_window frames, which at 60fps is most of a short game
+    if (bot.stats.games != games_before)
     {
-      switch (menu_selection)
-      {
-      case 0:
-        play_song = true;
-        NewGame();
-        current_state = GAME;
-        break;
-      case 1:
-        current_state = INSTRUCTIONS;
-        break;
-      case 2:
-        done = true;
-        break;
-      }
+      ProfileStats frame = GetProfileStats(PROFILE_FRAME);
+
+      printf("Bot game %i: climbed %i pixels, score %i. Frames avg %.2fms p99 %.2fms max %.2fms, %i steps dropped so far\n",
+             bot.stats.games, bot.stats.last_climb, bot.stats.last_score, frame.avg, frame.p99, frame.max, skips);
+      fflush(stdout);
     }
   }
-  else if (current_state == INSTRUCTIONS)
+  else if (!replaying)
   {
-    al_stop_sample_instance(song_instance);
+    input = KeyMask();
   }
 
+  RecordTick(recorder, input);
 
-  //Updates the current working fps
-  frames++;
-  if(al_current_time() - game_time >= 1)
+  last_view = next_view;
+  StepGame(game, input);
+  next_view = TakeView();
+
+  HandleEvents();
+
+  //Only while there's a game going that would be a shame to lose
+  if (game.current_state == GAME && !game.game_over && --autosave_countdown <= 0)
   {
-    game_time = al_current_time();
-    game_fps = frames;
-    frames = 0;
+    TRACE_SCOPE("Autosave");
+
+    SaveGame(autosave_path);
+    autosave_countdown = autosave_ticks;
   }
 
-  //Copies keys into old_keys for determining JustPressed
+  if (game.done)
+    done = true;
+}
+
+unsigned int KeyMask()
+{
+  unsigned int input = 0;
+
   for (int i = 0; i < num_keys; ++i)
   {
-    old_keys[i] = keys[i];
+    if (keys[i])
+      input |= 1u << i;
   }
 
-  redraw = true;
+  return input;
 }
 
-void Draw()
-{ 
-  al_set_target_bitmap(cam.screen); //Sets the render target to our camera bitmap
-  al_clear_to_color(al_map_rgb(0,0,0)); //Clears the screen to black
-  
+void StartIdling(ALLEGRO_TIMER *timer)
+{
+  if (idle)
+    return;
 
-  if (current_state == GAME)
-  {
-    //Run individual drawing functions
-    DrawBackground();
-    DrawPlatforms();
-    DrawPickups();
-    DrawPlayer();
-    DrawHUD();
-
-    if (paused)
-      DrawPauseScreen();
+  al_stop_timer(timer);
+  idle = true;
+  idle_start = al_get_time();
 
-    if (game_over)
-      DrawGameOverScreen();
-  }
-  else if (current_state == MENU)
-  {
-    al_draw_bitmap(images[11], 0, 0, 0);
+  //The next frame will be a long time after this one, that isn't a hitch
+  last_flip = 0;
+}
 
-    al_draw_text(fonts[1], al_map_rgb(255,255,255), 25, 5, 0, "Start");
-    al_draw_text(fonts[1], al_map_rgb(255,255,255), 25, 35, 0, "Instructions");
-    al_draw_text(fonts[1], al_map_rgb(255,255,255), 25, 65, 0, "Exit");
+void StopIdling(ALLEGRO_TIMER *timer)
+{
+  if (!idle)
+    return;
 
-    al_draw_filled_triangle(2, 10 + (30 * menu_selection), 2, 30 + (30 * menu_selection), 22, 20 + (30 * menu_selection), al_map_rgb(255,255,255));
-  }
-  else if (current_state == INSTRUCTIONS)
-  {
-    al_draw_bitmap(images[10], 0, 0, 0);
-  }
+  idle = false;
+  idle_time += al_get_time() - idle_start;
 
-  al_set_target_bitmap(al_get_backbuffer(display)); //Set render target to our back buffer
-  al_draw_bitmap(cam.screen, 0, 0, 0); //Draw the camera to the back buffer
-  al_flip_display();
+  last_time = al_get_time();
+  accumulator = 0;
+  al_start_timer(timer);
 }
 
-void CheckKeys(ALLEGRO_EVENT &ev, bool pressed)
+void HandleEvents()
 {
-  if(pressed)
+  for (int i = 0; i < game.num_events; ++i)
   {
-    switch(ev.keyboard.keycode)
+    switch (game.events[i].type)
     {
-    case ALLEGRO_KEY_ESCAPE:
-      current_state = MENU;
-      break;
-    case ALLEGRO_KEY_UP:
-      keys[UP] = true;
-      break;
-    case ALLEGRO_KEY_DOWN:
-      keys[DOWN] = true;
-      break;
-    case ALLEGRO_KEY_RIGHT:
-      keys[RIGHT] = true;
-      break;
-    case ALLEGRO_KEY_LEFT:
-      keys[LEFT] = true;
-      break;
-    case ALLEGRO_KEY_X:
-      keys[X] = true;
-      break;
-    case ALLEGRO_KEY_Z:
-      keys[Z] = true;
-      break;
-    case ALLEGRO_KEY_R:
-      keys[R] = true;
-      break;
-    case ALLEGRO_KEY_P:
-      keys[P] = true;
-      break;
-    case ALLEGRO_KEY_S:
-      keys[S] = true;
-      break;
-    case ALLEGRO_KEY_ENTER:
-      keys[ENTER] = true;
-      break;
-    }
-  }
-  else
-  {
-    switch(ev.keyboard.keycode)
+    case EVENT_SOUND:
     {
-    case ALLEGRO_KEY_UP:
-      keys[UP] = false;
-      break;
-    case ALLEGRO_KEY_DOWN:
-      keys[DOWN] = false;
-      break;
-    case ALLEGRO_KEY_RIGHT:
-      keys[RIGHT] = false;
-      break;
-    case ALLEGRO_KEY_LEFT:
-      keys[LEFT] = false;
-      break;
-    case ALLEGRO_KEY_X:
-      keys[X] = false;
-      break;
-    case ALLEGRO_KEY_Z:
-      keys[Z] = false;
+      TRACE_SCOPE("PlaySample");
+      PlayVoice(game.events[i].id);
       break;
-    case ALLEGRO_KEY_R:
-      keys[R] = false;
+    }
+    case EVENT_SONG_PLAY:
+      if (song_stream)
+        al_set_audio_stream_playing(song_stream, true);
       break;
-    case ALLEGRO_KEY_P:
-      keys[P] = false;
+    case EVENT_SONG_PAUSE:
+      if (song_stream)
+        al_set_audio_stream_playing(song_stream, false);
       break;
-    case ALLEGRO_KEY_S:
-      keys[S] = false;
+    case EVENT_SONG_STOP:
+      if (song_stream)
+      {
+        al_set_audio_stream_playing(song_stream, false);
+        al_rewind_audio_stream(song_stream);
+      }
       break;
-    case ALLEGRO_KEY_ENTER:
-      keys[ENTER] = false;
+    case EVENT_SUBMIT_SCORE:
+    {
+      TRACE_SCOPE("AddScore");
+
+      char name[4];
+
+      for (int j = 0; j < 3; ++j)
+        name[j] = name_chars[game.score_name[j]];
+
+      name[3] = '\0';
+
+      unsigned int when = (unsigned int)time(NULL);
+
+      if (!AddScore(game.events[i].id, name, when))
+        cerr << "Couldn't save score to scores.dat" << endl;
+
+      QueueScore(name, game.events[i].id, when);
       break;
     }
+    }
   }
+
+  game.num_events = 0;
+}
+
+bool SaveGame(const char *path)
+{
+  TakeSnapshot(game, snapshot);
+  return WriteSnapshot(path, snapshot);
 }
 
-bool JustPressed(int i)
+bool LoadGame(const char *path)
 {
-  if (old_keys[i] == false && keys[i] == true)
+  if (!ReadSnapshot(path, snapshot))
+    return false;
+
+  RestoreSnapshot(game, snapshot);
+
+  //Whatever the last step asked for has been played already
+  game.num_events = 0;
+
+  //The theme tune picks up where the restored game has it, from the start if it was stopped
+  if (song_stream)
   {
-    return true;
+    al_set_audio_stream_playing(song_stream, game.song_state == SONG_PLAYING);
+
+    if (game.song_state == SONG_STOPPED)
+      al_rewind_audio_stream(song_stream);
   }
-  else
+
+  //A replay only works from the start of a game, so recording or playing one back stops here
+  if (recorder.file)
   {
-    return false;
+    StopRecording(recorder);
+    cerr << "Stopped recording, a replay can't carry on from a restored game" << endl;
   }
+
+  if (replaying)
+  {
+    replaying = false;
+    StopPlayback(replay);
+  }
+
+  //Everything drawn is worked out again from the restored game
+  bot.jumping = false;
+  freeze_frame_taken = false;
+  last_view = next_view = TakeView();
+  autosave_countdown = autosave_ticks;
+  redraw = true;
+
+  return true;
 }
 
-void InitCamera()
+View TakeView()
 {
-  cam.x= 0;
-  cam.y = 0;
-  cam.last.x = 0;
-  cam.last.y = 0;
-  cam.width = WIDTH;
-  cam.height = HEIGHT;
-  cam.screen = al_create_bitmap(cam.width, cam.height);
+  View view;
+
+  view.player_x = game.player.x;
+  view.player_y = game.player.y;
+  view.cam_x = game.cam.x;
+  view.cam_y = game.cam.y;
+
+  return view;
 }
 
-void InitPlayer()
+//Blends one position, snapping straight to the new one if it jumped too far to have moved there (wrapping, new game)
+static float Blend(float from, float to, float alpha)
 {
-  player.width = 32;
-  player.height = 64;
-  player.scale_x = 1;
-  player.scale_y = 1;
-  player.rotation = 0;
-  player.facing = player.RIGHT;
-
-  player.x = 10;
-  player.y = (HEIGHT - (player.height * player.scale_y)) - 25;
-
-  player.max_speed = 5;
-  player.acceleration = 0.25;
-  player.deceleration = 0.2;
-  player.speed = 0;
-
-  player.gravity = 8;
-  player.y_velocity = player.gravity;
-  player.jump_power = 19;
-
-  player.health = 3;
-
-  player.state = player.WALKING;
-
-  player.sheet[0] = images[0];
-  player.frames[0] = 1;
-  player.sheet[1] = images[1];
-  player.frames[1] = 2;
-  player.sheet[2] = images[2];
-  player.frames[2] = 1;
-  player.sheet[3] = images[3];
-  player.frames[3] = 1;
-  player.sheet[4] = images[9];
-  player.frames[4] = 1;
-  player.sheet[5] = images[10];
-  player.frames[5] = 1;
-  player.sheet[6] = images[11];
-  player.frames[6] = 1;
-  
-
-  player.current_frame = 0;
-  player.current_animation = player.STAND;
-  player.frame_count = 0;
-  player.delay = 6;
-
-  player.sprite = al_create_bitmap(player.width, player.height);
-
-  zero = HEIGHT - (player.height * player.scale_y) - 25;
+  if (fabs(to - from) > max_blend_distance)
+    return to;
+
+  return from + (to - from) * alpha;
 }
 
-void UpdatePlayer()
+View BlendView(const View &from, const View &to, float alpha)
 {
-  if (player.state == player.WALKING)
-  {
-	  if (keys[LEFT])
-    {
-      player.facing = player.LEFT;
-      if (player.speed > 0)
-      {
-        ChangePlayerAnimation(player.SKID, false);
-      }
-      else
-      {
-        ChangePlayerAnimation(player.RUN, false);
-      }
-    }
-    else if (keys[RIGHT])
-    {
-      player.facing = player.RIGHT;
-      if (player.speed < 0)
-      {
-        ChangePlayerAnimation(player.SKID, false);
-      }
-      else
-      {
-        ChangePlayerAnimation(player.RUN, false);
-      }
-    }
-    else
-    {
-      ChangePlayerAnimation(player.STAND, false);
-    }
+  View view;
 
-    if (JustPressed(UP) || JustPressed(X))
-    {
-      player.state = player.JUMPING;
-      player.y_velocity = -player.jump_power;
-      al_play_sample(sounds[3], 1, 0, 1, ALLEGRO_PLAYMODE_ONCE, 0);
-    }
-  }
+  view.player_x = Blend(from.player_x, to.player_x, alpha);
+  view.player_y = Blend(from.player_y, to.player_y, alpha);
+  view.cam_x = Blend(from.cam_x, to.cam_x, alpha);
+  view.cam_y = Blend(from.cam_y, to.cam_y, alpha);
 
-  if (keys[LEFT])
-  {
-    player.facing = player.LEFT;
+  return view;
+}
 
-    if (player.speed <= 0)
-    {
-      player.speed -= player.acceleration;
-    }
-    else
-    {
-      player.speed -= player.deceleration;
-    }
+void Draw()
+{
+  bool frozen = Frozen();
 
-    if (player.speed < -player.max_speed)
-      player.speed = -player.max_speed;
-  }
-  else if (keys[RIGHT])
-  {
-    player.facing = player.RIGHT;
+  //Draw everything part way between the last two steps, by however far we are through the next one.
+  //Frozen, nothing's moving so draw the last step as it is rather than catching it up over the next frame
+  view = frozen ? next_view : BlendView(last_view, next_view, (float)(accumulator / step_time));
+  drawn_overlay = TakeOverlay();
 
-    if (player.speed >= 0)
-    {
-      player.speed += player.acceleration;
-    }
-    else
-    {
-      player.speed += player.deceleration;
-    }
+  if (!frozen)
+    freeze_frame_taken = false;
 
-    if (player.speed > player.max_speed)
-      player.speed = player.max_speed;
-  }
-  else
-  {
-    if (player.speed < 0 && player.speed > -player.deceleration)
-    {
-      player.speed = 0;
-    }
-    else if (player.speed > 0 && player.speed < player.deceleration)
-    {
-      player.speed = 0;
-    }
+  double draw_start = ProfileNow();
 
-    if (player.speed < 0)
-    {
-      player.speed += player.deceleration;
-    }
-    else if (player.speed > 0)
-    {
-      player.speed -= player.deceleration;
-    }
-  }
-  
-  if (keys[LEFT])
-    {
-      if (player.speed <= 0)
-      {
-        player.speed -= player.acceleration;
-      }
-      else
-      {
-        player.speed -= player.deceleration;
-      }
+  al_set_target_bitmap(cam_screen); //Sets the render target to our camera bitmap
+  al_clear_to_color(al_map_rgb(0,0,0)); //Clears the screen to black
 
-      if (player.speed < -player.max_speed)
-        player.speed = -player.max_speed;
-    }
-    else if (keys[RIGHT])
-    {
-      if (player.speed >= 0)
-      {
-        player.speed += player.acceleration;
-      }
-      else
-      {
-        player.speed += player.deceleration;
-      }
 
-      if (player.speed > player.max_speed)
-        player.speed = player.max_speed;
+  if (!menu_loaded)
+  {
+    DrawLoading();
+  }
+  else if (game.current_state == GAME)
+  {
+    if (freeze_frame_taken)
+    {
+      al_draw_bitmap(freeze_frame, 0, 0, 0);
     }
     else
     {
-      if (player.speed < 0 && player.speed > -player.deceleration)
-      {
-        player.speed = 0;
-      }
-      else if (player.speed > 0 && player.speed < player.deceleration)
+      //Run individual drawing functions, everything drawn from the atlas while drawing is held goes out as one batch.
+      //Nothing in a held section can change the render target or draw primitives, so the background goes first
+      DrawBackground();
+
+      al_hold_bitmap_drawing(true);
+      DrawPlatforms();
+      DrawPickups();
+      DrawEnemies();
+      DrawPlayer();
       {
-        player.speed = 0;
+        PROFILE_SCOPE(PROFILE_DRAW_BATCH);
+        al_hold_bitmap_drawing(false);
       }
 
-      if (player.speed < 0)
-      {
-        player.speed += player.deceleration;
-      }
-      else if (player.speed > 0)
+      DrawHUD();
+
+      //Keep it before the overlay goes on, every frame until the game carries on is drawn from it
+      if (frozen && freeze_frame)
       {
-        player.speed -= player.deceleration;
+        al_set_target_bitmap(freeze_frame);
+        al_draw_bitmap(cam_screen, 0, 0, 0);
+        al_set_target_bitmap(cam_screen);
+        freeze_frame_taken = true;
       }
     }
-  
-  if (player.state == player.JUMPING && !(JustPressed(UP) || JustPressed(X)))
+
+    if (game.paused)
+      DrawPauseScreen();
+
+    if (game.game_over)
+      DrawGameOverScreen();
+  }
+  else if (game.current_state == MENU)
   {
-    ChangePlayerAnimation(player.JUMP, false);
+    al_draw_bitmap(images[11], 0, 0, 0);
 
-    allow_double_jump = true;
+    SetCachedText(texts[TEXT_START], fonts[1], "Start");
+    SetCachedText(texts[TEXT_INSTRUCTIONS], fonts[1], "Instructions");
+    SetCachedText(texts[TEXT_LEADERBOARD], fonts[1], "High Scores");
+    SetCachedText(texts[TEXT_EXIT], fonts[1], "Exit");
 
-    if (player.y_velocity < player.gravity)
-    {
-      player.y_velocity += 1;
-    }
-    else if (player.y_velocity >= 0)
-    {
-      player.state = player.FALLING;
-    }
+    DrawCachedText(texts[TEXT_START], al_map_rgb(255,255,255), 25, 5, 0);
+    DrawCachedText(texts[TEXT_INSTRUCTIONS], al_map_rgb(255,255,255), 25, 35, 0);
+    DrawCachedText(texts[TEXT_LEADERBOARD], al_map_rgb(255,255,255), 25, 65, 0);
+    DrawCachedText(texts[TEXT_EXIT], al_map_rgb(255,255,255), 25, 95, 0);
+
+    al_draw_filled_triangle(2, 10 + (30 * game.menu_selection), 2, 30 + (30 * game.menu_selection), 22, 20 + (30 * game.menu_selection), al_map_rgb(255,255,255));
+
+    //The menu shows up before the rest has loaded, but it won't do anything until it has
+    if (!loaded)
+      DrawLoadingBar(HEIGHT - 20);
   }
-  else if (player.state == player.FALLING)
+  else if (game.current_state == INSTRUCTIONS)
   {
-    if (player.y_velocity < player.gravity)
-    {
-      ++player.y_velocity;
-    }
+    al_draw_bitmap(images[10], 0, 0, 0);
+  }
+  else if (game.current_state == LEADERBOARD)
+  {
+    DrawLeaderboard();
   }
 
-  //Apply forces to player
-  player.y += player.y_velocity;
-  player.x += player.speed;
-
-  //Update hitbox and corners
-  player.bottom_left.y = player.y + player.height * player.scale_y;
-  player.bottom_right.y = player.y + player.height * player.scale_y;
-  player.bottom_left.x = player.x;
-  player.bottom_right.x = player.x + (player.width * player.scale_x);
+  if (show_profiler && fonts[0])
+    DrawProfiler();
 
-  player.hitbox.bottom_right = player.bottom_right;
-  player.hitbox.top_left.x = player.x;
-  player.hitbox.top_left.y = player.y;
+  al_set_target_bitmap(al_get_backbuffer(display)); //Set render target to our back buffer
+  al_draw_bitmap(cam_screen, 0, 0, 0); //Draw the camera to the back buffer
 
-  if (player.x < -(player.width * player.scale_x)) //Wrap player if he goes off the left side
-    player.x = WIDTH;
+  double flip_start = ProfileNow();
+  al_flip_display();
+  double now = ProfileNow();
 
-  if (player.x > WIDTH) // Wrap player if he goes off the right side
-    player.x = -(player.width * player.scale_x);
+  ProfileSpan(PROFILE_DRAW, draw_start, flip_start);
+  ProfileSpan(PROFILE_FLIP, flip_start, now);
 
-  if (PlayerCollidePlatforms() != -1) //Check for a collision
+  //Time between flips, this is what the player actually sees
+  if (last_flip > 0)
   {
-    player.state = player.WALKING; //Change player state to walking
-    player.y_velocity = 0; //Kill the downward velocity
-    allow_double_jump = false;
-    has_double_jumped = false;
-    player.y = platforms[PlayerCollidePlatforms()].y - (player.height * player.scale_y); //Make sure the player hasn't sunk into the platform
-  }
-  else
-  {
-    if (player.state != player.JUMPING)
-    {
-      player.state = player.FALLING; //If we're not jumping and we aren't touching the ground then we must be falling
-    }
+    ProfileSpan(PROFILE_FRAME, last_flip, now);
 
-    if ((JustPressed(UP) || JustPressed(X)) && stars > 0 && allow_double_jump && !has_double_jumped)
+    //Save what led up to a hitch, but not again straight away or one bad patch fills the disk
+    if (hitch_time > 0 && now - last_flip > hitch_time && now - last_hitch > 10000)
     {
-      player.state = player.JUMPING;
-      player.y_velocity = -player.jump_power;
-      --stars;
-      allow_double_jump = false;
-      has_double_jumped = true;
-      al_play_sample(sounds[4], 1, 0, 1, ALLEGRO_PLAYMODE_ONCE, 0);
+      char path[64];
+      sprintf(path, "hitch-%i.json", ++hitches);
+      WriteTrace(path, 5);
+      last_hitch = now;
     }
   }
 
-  PlayerCollidePickups();
-}
-
-void DrawPlayer()
-{
-  al_set_target_bitmap(player.sprite); //Set the target to the player sprite image
-  al_clear_to_color(al_map_rgba(0,0,0,0)); //Clear the sprite to transparent
+  last_flip = now;
 
-  if (player.frame_count >= player.delay) //If the delay has passed
+  //Updates the current working fps
+  frames++;
+  frames_drawn++;
+  if(al_current_time() - game_time >= 1)
   {
-    player.frame_count = 0; //Set counter to zero
-    ++player.current_frame; //Increment the current frame
-    
-    if (player.current_frame > player.frames[player.current_animation] - 1) //if we've gone past the last frame
-      player.current_frame = 0; //Go back to the first frame
-  }
-  
-  if (!paused && !game_over)
-    ++player.frame_count; //Increment delay counter
+    double cpu_time = ProcessCpuTime();
 
-  if (player.facing == player.RIGHT)
-  {
-    al_draw_bitmap_region(player.sheet[player.current_animation], player.current_frame * player.width, 0, player.width, player.height, 0, 0, 0);
-  }
-  else if (player.facing == player.LEFT)
-  {
-    al_draw_bitmap_region(player.sheet[player.current_animation], player.current_frame * player.width, 0, player.width, player.height, 0, 0, ALLEGRO_FLIP_HORIZONTAL);
-  }
+    cpu_usage = 100 * (cpu_time - last_cpu_time) / (al_current_time() - game_time);
+    last_cpu_time = cpu_time;
 
-  al_set_target_bitmap(cam.screen);
-  
-  al_draw_scaled_bitmap(player.sprite, 0, 0, player.width, player.height, player.x - cam.x, player.y + cam.y, player.width * player.scale_x, player.height * player.scale_y, 0);
+    game_time = al_current_time();
+    game_fps = frames;
+    frames = 0;
+  }
 }
 
-void ChangePlayerAnimation(int animation, bool hard)
+bool Frozen()
 {
-  if (hard || player.current_animation != animation)
-  {
-    player.frame_count = 0;
-    player.current_frame = 0;
-    player.current_animation = animation;
-  }
+  return game.current_state == GAME && (game.paused || game.game_over);
 }
 
-void SpawnPlatform(int x, int y, int width, int height, int id)
+Overlay TakeOverlay()
 {
-  int count = width / 32;
+  Overlay overlay;
 
-  if (id == -1)
-  {
-    for (int i = 0; i < max_platforms; ++i)
-    {
-      if (!platforms[i].alive)
-      {
-        platforms[i].x = x;
-        platforms[i].y = y;
-        platforms[i].width = width;
-        platforms[i].height = height;
-        platforms[i].alive = true;
-        platforms[i].sprite = al_create_bitmap(width, height);
-
-        platforms[i].hitbox.top_left.x = x;
-        platforms[i].hitbox.top_left.y = y;
-        platforms[i].hitbox.bottom_right.x = x + width;
-        platforms[i].hitbox.bottom_right.y = y + height;
+  //Cleared so the padding compares equal too
+  memset(&overlay, 0, sizeof(Overlay));
 
-        al_set_target_bitmap(platforms[i].sprite);
+  overlay.state = game.current_state;
+  overlay.paused = game.paused;
+  overlay.game_over = game.game_over;
+  overlay.submit_score = game.submit_score;
+  overlay.name_entered = game.name_entered;
+  overlay.fade = game.game_over_fade;
+  overlay.submit_selection = game.submit_selection;
 
-        for (int j = 0; j < count + 1; ++j)
-        {
-          al_draw_bitmap(images[4], j * 32, 0, 0);
-        }
+  for (int i = 0; i < 3; ++i)
+    overlay.score_name[i] = game.score_name[i];
 
-        num_platforms++;
+  return overlay;
+}
 
+void CheckKeys(ALLEGRO_EVENT &ev, bool pressed)
+{
+  if(pressed)
+  {
+    switch(ev.keyboard.keycode)
+    {
+    case ALLEGRO_KEY_ESCAPE:
+      keys[ESCAPE] = true;
+      break;
+    case ALLEGRO_KEY_F1:
+      show_profiler = !show_profiler;
+      profiling = show_profiler || profile_run;
+      redraw = true;
+      break;
+    case ALLEGRO_KEY_F2:
+    {
+      if (!tracing)
+      {
+        cerr << "Not recording a trace, start with -trace" << endl;
         break;
       }
+
+      char path[64];
+      sprintf(path, "trace-%i.json", ++traces);
+      WriteTrace(path, 5);
+      break;
+    }
+    case ALLEGRO_KEY_F5:
+      if (loaded && !SaveGame(quicksave_path))
+        cerr << "Couldn't save to " << quicksave_path << endl;
+      break;
+    case ALLEGRO_KEY_F9:
+      if (loaded && !LoadGame(quicksave_path))
+        cerr << "Couldn't load " << quicksave_path << endl;
+      break;
+    case ALLEGRO_KEY_UP:
+      keys[UP] = true;
+      break;
+    case ALLEGRO_KEY_DOWN:
+      keys[DOWN] = true;
+      break;
+    case ALLEGRO_KEY_RIGHT:
+      keys[RIGHT] = true;
+      break;
+    case ALLEGRO_KEY_LEFT:
+      keys[LEFT] = true;
+      break;
+    case ALLEGRO_KEY_X:
+      keys[X] = true;
+      break;
+    case ALLEGRO_KEY_Z:
+      keys[Z] = true;
+      break;
+    case ALLEGRO_KEY_R:
+      keys[R] = true;
+      break;
+    case ALLEGRO_KEY_P:
+      keys[P] = true;
+      break;
+    case ALLEGRO_KEY_S:
+      keys[S] = true;
+      break;
+    case ALLEGRO_KEY_ENTER:
+      keys[ENTER] = true;
+      break;
     }
   }
   else
   {
-    if (!platforms[id].alive)
+    switch(ev.keyboard.keycode)
     {
-      platforms[id].x = x;
-      platforms[id].y = y;
-      platforms[id].width = width;
-      platforms[id].height = height;
-      platforms[id].alive = true;
-      platforms[id].sprite = al_create_bitmap(width, height);
-
-      platforms[id].hitbox.top_left.x = x;
-      platforms[id].hitbox.top_left.y = y;
-      platforms[id].hitbox.bottom_right.x = x + width;
-      platforms[id].hitbox.bottom_right.y = y + height;
-
-      al_set_target_bitmap(platforms[id].sprite);
-
-      for (int j = 0; j < count + 1; ++j)
-      {
-        al_draw_bitmap(images[4], j * 32, 0, 0);
-      }
-
-      num_platforms++;
-
-      int rand_pickup = Rand(100);
-
-      if (rand_pickup <= coin_chance)
-      {
-        SpawnPickup((x + (width / 2)) - 18, y - 50, COIN);
-      }
-      else if (rand_pickup > coin_chance && rand_pickup <= coin_chance + star_chance)
-      {
-        SpawnPickup((x + (width / 2)) - 18, y - 50, STAR);
-      }
+    case ALLEGRO_KEY_ESCAPE:
+      keys[ESCAPE] = false;
+      break;
+    case ALLEGRO_KEY_UP:
+      keys[UP] = false;
+      break;
+    case ALLEGRO_KEY_DOWN:
+      keys[DOWN] = false;
+      break;
+    case ALLEGRO_KEY_RIGHT:
+      keys[RIGHT] = false;
+      break;
+    case ALLEGRO_KEY_LEFT:
+      keys[LEFT] = false;
+      break;
+    case ALLEGRO_KEY_X:
+      keys[X] = false;
+      break;
+    case ALLEGRO_KEY_Z:
+      keys[Z] = false;
+      break;
+    case ALLEGRO_KEY_R:
+      keys[R] = false;
+      break;
+    case ALLEGRO_KEY_P:
+      keys[P] = false;
+      break;
+    case ALLEGRO_KEY_S:
+      keys[S] = false;
+      break;
+    case ALLEGRO_KEY_ENTER:
+      keys[ENTER] = false;
+      break;
     }
   }
 }
 
-void UpdatePlatforms()
+void DrawPlayer()
 {
-  int i = 0;
-  
-  //Loop through the whole platform array
-  for (i = 0; i < max_platforms; ++i)
-  {
-    if (platforms[i].alive)
-    {
-      //If the platform is 200 pixels off the screen we can consider it useless and remove it
-      if (platforms[i].y > (-cam.y + cam.height + 100))
-      {
-        RemovePlatform(i);
-        break;
-      }
-    }
-    else //If platform is not alive we make use of it by spawning a new one in it's place
-    {
-      next_width = platform_widths[Rand(11)];
-      next_width -= Rand(50);
+  PROFILE_SCOPE(PROFILE_DRAW_PLAYER);
 
-      platform_spawn.y -= platform_increment * dificulty;
-      platform_spawn.x = ((WIDTH / 5) * Rand(5)) - (next_width / 2) + 50;
-      
+  Player &player = game.player;
 
-      SpawnPlatform(platform_spawn.x, platform_spawn.y, next_width, 32, i);
-    }
-  }
-}
+  //Flash while the player can't be hurt
+  if ((player.invulnerable / 4) % 2 == 1)
+    return;
 
-void DrawPlatforms()
-{
-  al_set_target_bitmap(cam.screen);
+  //The first four images are the sheets for each animation, in the same order as Player::animations
+  ALLEGRO_BITMAP *sheet = images[player.current_animation];
 
-  for (int i = 0; i < max_platforms; ++i)
-  {
-    if (platforms[i].alive)
-    {
-      al_draw_bitmap(platforms[i].sprite, platforms[i].x - cam.x, platforms[i].y + cam.y, 0);
-    }
-  } 
-}
+  int flags = player.facing == player.LEFT ? ALLEGRO_FLIP_HORIZONTAL : 0;
 
-void RemovePlatform(int id)
-{
-  platforms[id].alive = false;
-  al_destroy_bitmap(platforms[id].sprite);
-  --num_platforms;
+  //Flip, scale and rotate around the middle of the frame in one go, straight from the sheet
+  float centre_x = player.width / 2;
+  float centre_y = player.height / 2;
+
+  al_draw_tinted_scaled_rotated_bitmap_region(sheet, player.current_frame * player.width, 0, player.width, player.height, al_map_rgb(255,255,255),
+    centre_x, centre_y, view.player_x - view.cam_x + (centre_x * player.scale_x), view.player_y + view.cam_y + (centre_y * player.scale_y),
+    player.scale_x, player.scale_y, player.rotation, flags);
 }
 
-int PlayerCollidePlatforms()
+void CreatePlatformStrip()
 {
-  for (int i = 0; i < max_platforms; ++i)
+  int count = platform_strip_width / 32;
+
+  platform_strip = al_create_bitmap(platform_strip_width, 32);
+
+  al_set_target_bitmap(platform_strip);
+
+  for (int j = 0; j < count + 1; ++j)
   {
-    if (platforms[i].alive)
-    {
-      if (player.state == player.FALLING || player.state == player.WALKING)
-      {
-	      if ((player.bottom_left.x >= platforms[i].hitbox.top_left.x && player.bottom_left.x <= platforms[i].hitbox.bottom_right.x) && (player.bottom_left.y >= platforms[i].hitbox.top_left.y && player.bottom_left.y <= platforms[i].hitbox.bottom_right.y) ||
-	            (player.bottom_right.x >= platforms[i].hitbox.top_left.x && player.bottom_right.x <= platforms[i].hitbox.bottom_right.x) && (player.bottom_right.y >= platforms[i].hitbox.top_left.y && player.bottom_right.y <= platforms[i].hitbox.bottom_right.y))
-	      {
-	        return i;
-	      }
-      } 
-      else if (player.state == player.JUMPING)
-      {
-        return -1;
-      }
-    }
+    al_draw_bitmap(images[4], j * 32, 0, 0);
   }
 
-  return -1;
+  al_set_target_backbuffer(display);
 }
 
-void SpawnPickup(int x, int y, int type)
+void CreateBackgroundTiles()
 {
-  for (int i = 0; i < max_pickups; ++i)
+  for (int i = 0; i < num_background_layers; ++i)
   {
-    if (!pickups[i].alive)
-    {
-      pickups[i].alive = true;
-      pickups[i].x = x;
-      pickups[i].y = y;
-      pickups[i].type = type;
-      pickups[i].current_frame = 0;
-      pickups[i].delay = 6;
-      pickups[i].frame_count = 0;
-      
-      pickups[i].hitbox.top_left.x = x;
-      pickups[i].hitbox.top_left.y = y;
-      pickups[i].hitbox.bottom_right.x = x + 32;
-      pickups[i].hitbox.bottom_right.y = y + 32;
-      
-      switch (type)
-      {
-      case COIN:
-        pickups[i].sheet = images[6];
-        pickups[i].frames = 4;
-        break;
-      case STAR:
-        pickups[i].sheet = images[9];
-        pickups[i].frames = 4;
-        break;
-      }
+    const BackgroundLayer &layer = background_layers[i];
+    ALLEGRO_BITMAP *image = images[layer.image];
 
-      break;
-    }
+    if (!image)
+      continue;
+
+    //A video bitmap of its own, wrapping only works on whole textures and not parts of the atlas
+    ALLEGRO_BITMAP *tile = al_create_bitmap(al_get_bitmap_width(image), layer.period);
+
+    if (!tile)
+      continue;
+
+    al_set_target_bitmap(tile);
+    al_draw_bitmap_region(image, 0, 0, al_get_bitmap_width(image), layer.period, 0, 0, 0);
+
+    al_destroy_bitmap(image);
+    images[layer.image] = tile;
   }
+
+  al_set_target_backbuffer(display);
 }
 
-void UpdatePickups()
+//The title and instructions are drawn on their own and the background wraps, everything else goes in the atlas
+static bool InAtlas(int image)
 {
-  for (int i = 0; i < max_pickups; ++i)
+  if (image == 10 || image == 11)
+    return false;
+
+  for (int i = 0; i < num_background_layers; ++i)
   {
-    if (pickups[i].alive)
-    {
-      if (pickups[i].y > (-cam.y + cam.height + 100))
-      {
-        RemovePickup(i);
-        break;
-      }
-    }
+    if (background_layers[i].image == image)
+      return false;
   }
+
+  return true;
 }
 
-void PlayerCollidePickups()
+void DrawPlatforms()
 {
-  for (int i = 0; i < max_pickups; ++i)
+  PROFILE_SCOPE(PROFILE_DRAW_PLATFORMS);
+
+  //Start from the lowest platform on screen and go up until they're above it
+  for (int n = FindPlatform(game, HEIGHT - view.cam_y); n < game.num_platforms; ++n)
   {
-    if (pickups[i].alive)
+    int i = PlatformSlot(game, n);
+    const Platforms &platforms = game.platforms;
+
+    if (platforms.bottom[i] + view.cam_y < 0)
+      break;
+
+    int platform_width = platforms.right[i] - platforms.x[i];
+    int platform_height = platforms.bottom[i] - platforms.y[i];
+
+    //Every platform is the same tile repeated from its left edge, so it's just the first width pixels of the strip
+    for (int x = 0; x < platform_width; x += platform_strip_width)
     {
-      if (((pickups[i].hitbox.top_left.x < player.hitbox.top_left.x && pickups[i].hitbox.bottom_right.x > player.hitbox.top_left.x) ||
-          (pickups[i].hitbox.top_left.x < player.hitbox.bottom_right.x && pickups[i].hitbox.bottom_right.x > player.hitbox.top_left.x))
-          &&
-          ((pickups[i].hitbox.top_left.y < player.hitbox.top_left.y && pickups[i].hitbox.bottom_right.y > player.hitbox.top_left.y) ||
-          (pickups[i].hitbox.top_left.y < player.hitbox.bottom_right.y && pickups[i].hitbox.bottom_right.y > player.hitbox.top_left.y)))
-      {
-        CollectPickup(i);
-        break;
-      }
+      int width = platform_width - x < platform_strip_width ? platform_width - x : platform_strip_width;
+
+      al_draw_bitmap_region(platform_strip, 0, 0, width, platform_height, platforms.x[i] + x - view.cam_x, platforms.y[i] + view.cam_y, 0);
     }
   }
 }
 
-void CollectPickup(int id)
+void DrawPickups()
 {
-  switch(pickups[id].type)
+  PROFILE_SCOPE(PROFILE_DRAW_PICKUPS);
+
+  const Pickups &pickups = game.pickups;
+
+  for (int i = 0; i < game.num_pickups; ++i)
   {
-  case COIN:
-    score += 10;
-    coins++;
-    al_play_sample(sounds[0], 1, 0, 1, ALLEGRO_PLAYMODE_ONCE, 0);
-    break;
-  case STAR:
-    stars++;
-    al_play_sample(sounds[1], 1, 0, 1, ALLEGRO_PLAYMODE_ONCE, 0);
-    break;
-  }
+    ALLEGRO_BITMAP *sheet = pickups.type[i] == STAR ? images[9] : images[6];
 
-  RemovePickup(id);
+    al_draw_bitmap_region(sheet, pickup_size * pickups.current_frame[i], 0, pickup_size, pickup_size, pickups.x[i] - view.cam_x, pickups.y[i] + view.cam_y, 0);
+  }
 }
 
-void RemovePickup(int id)
+void DrawEnemies()
 {
-  pickups[id].alive = false;
-}
+  PROFILE_SCOPE(PROFILE_DRAW_ENEMIES);
 
-void DrawPickups()
-{
-  al_set_target_bitmap(cam.screen);
+  const Enemies &enemies = game.enemies;
 
-  for (int i = 0; i < max_pickups; ++i)
+  for (int i = 0; i < game.num_enemies; ++i)
   {
-    if (pickups[i].alive)
+    if (enemies.dying[i] > 0)
     {
-      if (pickups[i].frame_count >= pickups[i].delay) //If the delay has passed
-      {
-        pickups[i].frame_count = 0; //Set counter to zero
-        ++pickups[i].current_frame; //Increment the current frame
-
-        if (pickups[i].current_frame > pickups[i].frames - 1) //if we've gone past the last frame
-          pickups[i].current_frame = 0; //Go back to the first frame
-      }
-
-      if (!paused && !game_over)
-        ++pickups[i].frame_count; //Increment delay counter
-
-      al_draw_bitmap_region(pickups[i].sheet, 32 * pickups[i].current_frame, 0, 32, 32, pickups[i].x - cam.x, pickups[i].y + cam.y, 0);
+      al_draw_bitmap(images[13], enemies.x[i] - view.cam_x, enemies.y[i] + view.cam_y, 0);
     }
-  } 
-}
+    else
+    {
+      int flags = enemies.speed[i] < 0 ? ALLEGRO_FLIP_HORIZONTAL : 0;
 
-void UpdateBackground()
-{
-  bg_offset += cam.y - cam.last.y;
-  if (bg_offset > 32)
-    bg_offset -= 32;
+      al_draw_bitmap_region(images[12], enemy_size * enemies.current_frame[i], 0, enemy_size, enemy_size, enemies.x[i] - view.cam_x, enemies.y[i] + view.cam_y, flags);
+    }
+  }
 }
 
 void DrawBackground()
 {
-  al_set_target_bitmap(cam.screen);
+  PROFILE_SCOPE(PROFILE_DRAW_BACKGROUND);
+
+  ALLEGRO_COLOR white = al_map_rgb(255,255,255);
+
+  for (int i = 0; i < num_background_layers; ++i)
+  {
+    const BackgroundLayer &layer = background_layers[i];
+    ALLEGRO_BITMAP *bitmap = images[layer.image];
+
+    //Texture coordinates past the bottom of the bitmap wrap back round to the top, so one quad covers the whole
+    //screen however tall it is. Kept small so they don't lose precision far up the tower
+    float top = -fmod(view.cam_y * layer.speed, (float)layer.period);
+    float width = al_get_bitmap_width(bitmap);
+
+    ALLEGRO_VERTEX vertices[4] =
+    {
+      {0, 0, 0, 0, top, white},
+      {WIDTH, 0, 0, width, top, white},
+      {0, HEIGHT, 0, 0, top + HEIGHT, white},
+      {WIDTH, HEIGHT, 0, width, top + HEIGHT, white}
+    };
 
-  al_draw_bitmap(images[5], 0, -32 + bg_offset, 0);
+    al_draw_prim(vertices, NULL, bitmap, 0, 4, ALLEGRO_PRIM_TRIANGLE_STRIP);
+  }
 }
 
 void DrawHUD()
 {
-  al_set_target_bitmap(cam.screen);
+  PROFILE_SCOPE(PROFILE_DRAW_HUD);
+
+  al_set_target_bitmap(cam_screen);
 
 
   al_draw_filled_rectangle(0, 0, WIDTH, 35, al_map_rgba(0,0,0,150));
-  al_draw_textf(fonts[1], al_map_rgb(255,255,255), 3, 3, 0, "Score: %i", (highest / 2) + score);
 
+  //These only render anything when the numbers have changed, and have to be done before drawing is held
+  SetCachedTextf(texts[TEXT_SCORE], fonts[1], "Score: %i", (game.highest / 2) + game.score);
+  SetCachedTextf(texts[TEXT_STARS], fonts[1], "%i", game.stars);
+  SetCachedText(texts[TEXT_TIMES], fonts[4], "x");
+
+  al_hold_bitmap_drawing(true);
   al_draw_bitmap_region(images[9], 0, 0, 32, 32, (WIDTH / 2) - 35, 3, 0);
-  al_draw_text(fonts[4], al_map_rgb(255,255,255), (WIDTH / 2), 10, ALLEGRO_ALIGN_LEFT, "x");
-  al_draw_textf(fonts[1], al_map_rgb(255,255,255), (WIDTH / 2) + 12, 5, ALLEGRO_ALIGN_LEFT, "%i", stars);
+  DrawCachedText(texts[TEXT_SCORE], al_map_rgb(255,255,255), 3, 3, 0);
+  DrawCachedText(texts[TEXT_STARS], al_map_rgb(255,255,255), (WIDTH / 2) + 12, 5, ALLEGRO_ALIGN_LEFT);
+  DrawCachedText(texts[TEXT_TIMES], al_map_rgb(255,255,255), (WIDTH / 2), 10, ALLEGRO_ALIGN_LEFT);
 
-  /*for (int i = 0; i < 3; ++i)
+  //One heart for each hit the player can take, full ones are the right half of the image and empty the left
+  for (int i = 0; i < 3; ++i)
   {
-    if (player.health >= i + 1)
-    {
-      al_draw_bitmap_region(images[7], 32, 0, 32, 32, (WIDTH - (i * 35)) - 35, 3, 0);
-    }
-    else
-    {
-      al_draw_bitmap_region(images[7], 0, 0, 32, 32, (WIDTH - (i * 35)) - 35, 3, 0);
-    }
-  }*/
+    int frame = game.player.health >= i + 1 ? 32 : 0;
+    al_draw_bitmap_region(images[7], frame, 0, 32, 32, (WIDTH - (i * 35)) - 35, 3, 0);
+  }
+
+  al_hold_bitmap_drawing(false);
 }
 
 void DrawPauseScreen()
 {
-  al_set_target_bitmap(cam.screen);
+  al_set_target_bitmap(cam_screen);
   al_draw_filled_rectangle(0, 0, WIDTH, HEIGHT, al_map_rgba(0,0,0,200));
-  al_draw_text(fonts[2], al_map_rgb(255,255,255), WIDTH / 2, 190, ALLEGRO_ALIGN_CENTER, "Paused");
+  SetCachedText(texts[TEXT_PAUSED], fonts[2], "Paused");
+  DrawCachedText(texts[TEXT_PAUSED], al_map_rgb(255,255,255), WIDTH / 2, 190, ALLEGRO_ALIGN_CENTER);
   al_draw_bitmap(images[8], (WIDTH / 2) - 45, 230, 0);
 }
 
 void DrawGameOverScreen()
 {
-  al_set_target_bitmap(cam.screen);
-  al_draw_filled_rectangle(0, 0, WIDTH, HEIGHT, al_map_rgba(0,0,0,game_over_fade));
+  al_set_target_bitmap(cam_screen);
+  al_draw_filled_rectangle(0, 0, WIDTH, HEIGHT, al_map_rgba(0,0,0,game.game_over_fade));
 
-  if (!submit_score)
+  if (!game.submit_score)
   {
-	  if (game_over_fade < 200)
-	  {
-	    game_over_fade += 10;
-	  }
-	  else
+	  if (game.game_over_fade >= 200)
 	  {
-	    al_draw_text(fonts[2], al_map_rgb(255,255,255), WIDTH / 2, 190, ALLEGRO_ALIGN_CENTER, "Game Over!");
+	    SetCachedText(texts[TEXT_GAME_OVER], fonts[2], "Game Over!");
+	    SetCachedText(texts[TEXT_DISTANCE_LABEL], fonts[1], "Distance Climbed:");
+	    SetCachedTextf(texts[TEXT_DISTANCE], fonts[1], "  %i pixels", game.highest);
+	    SetCachedText(texts[TEXT_COINS_LABEL], fonts[1], "Coins Collected:");
+	    SetCachedTextf(texts[TEXT_COINS], fonts[1], "  %i", game.coins);
+	    SetCachedText(texts[TEXT_TOTAL_LABEL], fonts[1], "Total Score:");
+	    SetCachedTextf(texts[TEXT_TOTAL], fonts[1], "  %i", (game.highest / 2) + game.score);
+	    SetCachedText(texts[TEXT_SUBMIT], fonts[1], "Press S to submit your score");
+	    SetCachedText(texts[TEXT_AGAIN], fonts[1], "Press R to have another go!");
+
+	    DrawCachedText(texts[TEXT_GAME_OVER], al_map_rgb(255,255,255), WIDTH / 2, 190, ALLEGRO_ALIGN_CENTER);
 	    al_draw_line(130, 240, 272, 240, al_map_rgb(255,0,0), 2);
-	    al_draw_text(fonts[1], al_map_rgb(255,255,255), WIDTH / 2, 245, ALLEGRO_ALIGN_RIGHT, "Distance Climbed:");
-	    al_draw_textf(fonts[1], al_map_rgb(255,255,255), WIDTH / 2, 245, ALLEGRO_ALIGN_LEFT, "  %i pixels", highest);
-	    al_draw_text(fonts[1], al_map_rgb(255,255,255), WIDTH / 2, 275, ALLEGRO_ALIGN_RIGHT, "Coins Collected:");
-	    al_draw_textf(fonts[1], al_map_rgb(255,255,255), WIDTH / 2, 275, ALLEGRO_ALIGN_LEFT, "  %i", coins);
-	    al_draw_text(fonts[1], al_map_rgb(255,255,255), WIDTH / 2, 305, ALLEGRO_ALIGN_RIGHT, "Total Score:");
-	    al_draw_textf(fonts[1], al_map_rgb(255,255,255), WIDTH / 2, 305, ALLEGRO_ALIGN_LEFT, "  %i", (highest / 2) + score);
-	    //al_draw_text(fonts[1], al_map_rgb(255,0,0), WIDTH / 2, 355, ALLEGRO_ALIGN_CENTER, "Press S to submit your score");
-	    al_draw_text(fonts[1], al_map_rgb(255,0,0), WIDTH / 2, 385, ALLEGRO_ALIGN_CENTER, "Press R to have another go!");
+	    DrawCachedText(texts[TEXT_DISTANCE_LABEL], al_map_rgb(255,255,255), WIDTH / 2, 245, ALLEGRO_ALIGN_RIGHT);
+	    DrawCachedText(texts[TEXT_DISTANCE], al_map_rgb(255,255,255), WIDTH / 2, 245, ALLEGRO_ALIGN_LEFT);
+	    DrawCachedText(texts[TEXT_COINS_LABEL], al_map_rgb(255,255,255), WIDTH / 2, 275, ALLEGRO_ALIGN_RIGHT);
+	    DrawCachedText(texts[TEXT_COINS], al_map_rgb(255,255,255), WIDTH / 2, 275, ALLEGRO_ALIGN_LEFT);
+	    DrawCachedText(texts[TEXT_TOTAL_LABEL], al_map_rgb(255,255,255), WIDTH / 2, 305, ALLEGRO_ALIGN_RIGHT);
+	    DrawCachedText(texts[TEXT_TOTAL], al_map_rgb(255,255,255), WIDTH / 2, 305, ALLEGRO_ALIGN_LEFT);
+	    DrawCachedText(texts[TEXT_SUBMIT], al_map_rgb(255,0,0), WIDTH / 2, 355, ALLEGRO_ALIGN_CENTER);
+	    DrawCachedText(texts[TEXT_AGAIN], al_map_rgb(255,0,0), WIDTH / 2, 385, ALLEGRO_ALIGN_CENTER);
 	  }
   }
   else
   {
     al_draw_text(fonts[1], al_map_rgb(255,255,255), WIDTH / 2, 145, ALLEGRO_ALIGN_CENTER, "Use the arrow keys to enter your initials");
 
-    al_draw_textf(fonts[3], al_map_rgb(255,255,255), 167, 200, ALLEGRO_ALIGN_CENTER, "%c", name_chars[score_name[0]]);
-    al_draw_textf(fonts[3], al_map_rgb(255,255,255), 198, 200, ALLEGRO_ALIGN_CENTER, "%c", name_chars[score_name[1]]);
-    al_draw_textf(fonts[3], al_map_rgb(255,255,255), 229, 200, ALLEGRO_ALIGN_CENTER, "%c", name_chars[score_name[2]]);
+    al_draw_textf(fonts[3], al_map_rgb(255,255,255), 167, 200, ALLEGRO_ALIGN_CENTER, "%c", name_chars[game.score_name[0]]);
+    al_draw_textf(fonts[3], al_map_rgb(255,255,255), 198, 200, ALLEGRO_ALIGN_CENTER, "%c", name_chars[game.score_name[1]]);
+    al_draw_textf(fonts[3], al_map_rgb(255,255,255), 229, 200, ALLEGRO_ALIGN_CENTER, "%c", name_chars[game.score_name[2]]);
 
-    al_draw_filled_triangle(154 + (submit_selection * 31), 202, 180 + (submit_selection * 31), 202, 167 + (submit_selection * 31), 188, al_map_rgb(255,255,255));
-    al_draw_filled_triangle(154 + (submit_selection * 31), 260, 180 + (submit_selection * 31), 260, 167 + (submit_selection * 31), 274, al_map_rgb(255,255,255));
+    al_draw_filled_triangle(154 + (game.submit_selection * 31), 202, 180 + (game.submit_selection * 31), 202, 167 + (game.submit_selection * 31), 188, al_map_rgb(255,255,255));
+    al_draw_filled_triangle(154 + (game.submit_selection * 31), 260, 180 + (game.submit_selection * 31), 260, 167 + (game.submit_selection * 31), 274, al_map_rgb(255,255,255));
 
     al_draw_text(fonts[1], al_map_rgb(255,255,255), WIDTH / 2, 290, ALLEGRO_ALIGN_CENTER, "Hit the enter key to submit");
   }
 }
 
-int Rand(int limit)
+void DrawLeaderboard()
 {
-  return (int)rand()%limit;
+  al_draw_bitmap(images[11], 0, 0, 0);
+  al_draw_filled_rectangle(0, 0, WIDTH, HEIGHT, al_map_rgba(0,0,0,200));
+
+  //The scores are only copied out and rendered when one has been added, not every frame
+  if (ScoresLoaded() && ScoresVersion() != top_scores_version)
+  {
+    num_top_scores = TopScores(top_scores, shown_scores);
+    top_scores_version = ScoresVersion();
+
+    for (int i = 0; i < num_top_scores; ++i)
+    {
+      SetCachedTextf(score_names[i], fonts[1], "%i.  %s", i + 1, top_scores[i].name);
+      SetCachedTextf(score_values[i], fonts[1], "%u", top_scores[i].score);
+    }
+  }
+
+  SetCachedText(texts[TEXT_SCORES_TITLE], fonts[2], "High Scores");
+  SetCachedText(texts[TEXT_SCORES_BACK], fonts[4], "Press escape to go back");
+  DrawCachedText(texts[TEXT_SCORES_TITLE], al_map_rgb(255,255,255), WIDTH / 2, 40, ALLEGRO_ALIGN_CENTER);
+
+  if (!ScoresLoaded() || num_top_scores == 0)
+  {
+    SetCachedText(texts[TEXT_SCORES_EMPTY], fonts[1], ScoresLoaded() ? "No scores yet" : "Loading...");
+    DrawCachedText(texts[TEXT_SCORES_EMPTY], al_map_rgb(255,255,255), WIDTH / 2, 200, ALLEGRO_ALIGN_CENTER);
+  }
+
+  for (int i = 0; i < num_top_scores; ++i)
+  {
+    DrawCachedText(score_names[i], al_map_rgb(255,255,255), 80, 110 + i * 35, ALLEGRO_ALIGN_LEFT);
+    DrawCachedText(score_values[i], al_map_rgb(255,255,255), WIDTH - 80, 110 + i * 35, ALLEGRO_ALIGN_RIGHT);
+  }
+
+  DrawCachedText(texts[TEXT_SCORES_BACK], al_map_rgb(255,0,0), WIDTH / 2, HEIGHT - 40, ALLEGRO_ALIGN_CENTER);
 }
 
-void NewGame()
+void DrawProfiler()
 {
-  int i;
+  //Working the stats out every frame would cost more than some of what they measure, a couple of times a second is plenty
+  if (profiler_refresh <= 0)
+  {
+    for (int i = 0; i < num_profile_sections; ++i)
+      profiler_stats[i] = GetProfileStats(i);
 
-  scrolling = false;
-  game_over = false;
+    profiler_refresh = 30;
+  }
 
-  game_over_fade = 0;
-  game_over_fade_2 = 0;
+  --profiler_refresh;
 
-  submit_score = false;
-  name_entered = false;
+  int line = al_get_font_line_height(fonts[0]);
+  int top = HEIGHT - (num_profile_sections + (sending_scores ? 4 : 3)) * line - 10;
+  ALLEGRO_COLOR white = al_map_rgb(255,255,255);
 
-  submit_selection = 0;
-  score_name[0] = 0;
-  score_name[1] = 0;
-  score_name[2] = 0;
+  al_draw_filled_rectangle(0, top - 5, WIDTH, HEIGHT, al_map_rgba(0,0,0,200));
 
-  paused = false;
-  
-  highest = 0;
-  score = 0;
-  coins = 0;
-  dificulty = 1;
+  al_hold_bitmap_drawing(true);
 
-  bg_offset = 0;
+  al_draw_textf(fonts[0], white, 5, top, 0, "FPS: %i   CPU: %.0f%%   Skipped steps: %i", game_fps, cpu_usage, skips);
+  top += line;
 
-  coin_chance = 33;
-  star_chance = 5;
+  VoiceStats voice_stats = GetVoiceStats();
+  al_draw_textf(fonts[0], white, 5, top, 0, "Voices: %i/%i   Stolen: %lld   Dropped: %lld   Rate limited: %lld",
+                voice_stats.playing, max_playing_sounds, voice_stats.steals, voice_stats.drops, voice_stats.limited);
+  top += line;
 
-  play_death = true;
+  if (sending_scores)
+  {
+    ScoreClientStats score_stats = GetScoreClientStats();
+    al_draw_textf(fonts[0], white, 5, top, 0, "Scores queued: %i   Sent: %lld   Failed: %lld   Latency: %.0fms   Retry in: %.0fs",
+                  score_stats.queued, score_stats.sent, score_stats.failures, score_stats.last_latency, score_stats.retry_in);
+    top += line;
+  }
+
+  al_draw_text(fonts[0], white, 5, top, 0, "ms");
+  al_draw_text(fonts[0], white, 200, top, ALLEGRO_ALIGN_RIGHT, "min");
+  al_draw_text(fonts[0], white, 265, top, ALLEGRO_ALIGN_RIGHT, "avg");
+  al_draw_text(fonts[0], white, 330, top, ALLEGRO_ALIGN_RIGHT, "p99");
+  al_draw_text(fonts[0], white, 395, top, ALLEGRO_ALIGN_RIGHT, "max");
+  top += line;
+
+  for (int i = 0; i < num_profile_sections; ++i)
+  {
+    al_draw_text(fonts[0], white, 5, top, 0, profile_names[i]);
+    al_draw_textf(fonts[0], white, 200, top, ALLEGRO_ALIGN_RIGHT, "%.3f", profiler_stats[i].min);
+    al_draw_textf(fonts[0], white, 265, top, ALLEGRO_ALIGN_RIGHT, "%.3f", profiler_stats[i].avg);
+    al_draw_textf(fonts[0], white, 330, top, ALLEGRO_ALIGN_RIGHT, "%.3f", profiler_stats[i].p99);
+    al_draw_textf(fonts[0], white, 395, top, ALLEGRO_ALIGN_RIGHT, "%.3f", profiler_stats[i].max);
+    top += line;
+  }
 
+  al_hold_bitmap_drawing(false);
+}
 
-  InitCamera();
-  InitPlayer();
+void TakeAssets()
+{
+  int ready = LoadedAssets();
 
-  //Remove all platforms
-  for (i = 0; i < max_platforms; ++i)
-    RemovePlatform(i);
+  for (; assets_taken < ready; ++assets_taken)
+  {
+    Asset &asset = assets[assets_taken];
 
-  //Remove all pickups
-  for (i = 0; i < max_pickups; ++i)
-    RemovePickup(i);
+    //Everything loaded is used somewhere, so rather than crash on it later stop here and say which one it was.
+    //It's stepped past so Destroy can still take the ones after it
+    if (!asset.data)
+    {
+      cerr << "Couldn't load " << asset.path << endl;
+      done = true;
+      continue;
+    }
 
-  //Spawn the starting platforms
-  SpawnPlatform(0, HEIGHT - 25, WIDTH, 32, -1);
-  SpawnPlatform(0, HEIGHT - 175, 100, 32, -1);
-  SpawnPlatform(125, HEIGHT - 250, 100, 32, -1);
-  SpawnPlatform(250, HEIGHT - 325, 100, 32, -1);
+    switch (asset.type)
+    {
+    case ASSET_BITMAP:
+      images[asset.index] = (ALLEGRO_BITMAP *)asset.data;
 
-  platform_spawn.y = HEIGHT - 325;
+      //Full screen images aren't packed in to the atlas, upload them straight away so the menu can show
+      if (asset.index == 10 || asset.index == 11)
+        al_convert_bitmap(images[asset.index]);
+      break;
+    case ASSET_FONT:
+      fonts[asset.index] = (ALLEGRO_FONT *)asset.data;
+      break;
+    case ASSET_SAMPLE:
+      sounds[asset.index] = (ALLEGRO_SAMPLE *)asset.data;
+      break;
+    }
+  }
 
-  new_game = false;
+  if (images[11] && fonts[1])
+    menu_loaded = true;
+}
+
+void FinishLoading()
+{
+  TRACE_SCOPE("FinishLoading");
+
+  StopLoading();
+
+  //The strip is only copied in to the atlas, so it doesn't need uploading
+  int bitmap_flags = al_get_new_bitmap_flags();
+  al_set_new_bitmap_flags(ALLEGRO_MEMORY_BITMAP);
+
+  CreatePlatformStrip();
+
+  al_set_new_bitmap_flags(bitmap_flags);
+
+  CreateBackgroundTiles();
+
+  //Pack every sprite in to one texture so a whole frame can be drawn in a few batches
+  ALLEGRO_BITMAP *sprites[num_images + 1];
+  int num_sprites = 0;
+
+  //Anything missing is left out rather than packed, and stays NULL
+  for (int i = 0; i < num_images; ++i)
+  {
+    if (InAtlas(i) && images[i])
+      sprites[num_sprites++] = images[i];
+  }
+
+  if (platform_strip)
+    sprites[num_sprites++] = platform_strip;
+
+  atlas = BuildAtlas(sprites, num_sprites, 2048);
+
+  if (atlas)
+  {
+    num_sprites = 0;
+
+    for (int i = 0; i < num_images; ++i)
+    {
+      if (InAtlas(i) && images[i])
+        images[i] = sprites[num_sprites++];
+    }
+
+    if (platform_strip)
+      platform_strip = sprites[num_sprites];
+  }
+  else //Too big for this graphics card, upload them one at a time instead
+  {
+    al_convert_memory_bitmaps();
+  }
+
+  //Decoded on the audio thread a few buffers ahead of where it's playing. The stream keeps the file and closes it when it's destroyed
+  ALLEGRO_FILE *song_file = OpenAsset(&pack, "Assets/Audio/song.ogg");
+
+  if (song_file)
+    song_stream = al_load_audio_stream_f(song_file, ".ogg", 4, 2048);
+
+  if (song_stream)
+  {
+    al_set_audio_stream_playmode(song_stream, ALLEGRO_PLAYMODE_LOOP);
+    al_set_audio_stream_playing(song_stream, game.song_state == SONG_PLAYING); //Playing already if a game was restored
+    al_attach_audio_stream_to_mixer(song_stream, al_get_default_mixer());
+  }
+
+  CreateVoices(sounds, sound_settings, num_sounds, max_playing_sounds);
+
+  al_destroy_bitmap(load_bitmap);
+  load_bitmap = NULL;
+
+  loaded = true;
+}
+
+void DrawLoading()
+{
+  if (load_bitmap)
+    al_draw_bitmap(load_bitmap, (WIDTH / 2) - 125, 250, 0);
+
+  DrawLoadingBar(350);
+}
+
+void DrawLoadingBar(int y)
+{
+  float left = (WIDTH / 2) - 125;
+  float right = (WIDTH / 2) + 125;
+  float done = left + (right - left) * assets_taken / num_assets;
+
+  al_draw_rectangle(left, y, right, y + 10, al_map_rgb(255,255,255), 1);
+  al_draw_filled_rectangle(left, y, done, y + 10, al_map_rgb(255,255,255));
+
+  //A little block sliding along the part still to go
+  if (done < right - 20)
+  {
+    float x = done + fmod(al_get_time() * 150, right - 20 - done);
+    al_draw_filled_rectangle(x, y + 2, x + 20, y + 8, al_map_rgb(128,128,128));
+  }
 }
 
 void Destroy()
 {
   int i;
 
+  //Anything the loader finished after we stopped taking them still needs destroying
+  StopLoading();
+  TakeAssets();
+
+  for (i = 0; i < num_cached_texts; ++i)
+    DestroyCachedText(texts[i]);
+
+  for (i = 0; i < shown_scores; ++i)
+  {
+    DestroyCachedText(score_names[i]);
+    DestroyCachedText(score_values[i]);
+  }
+
+  CloseScores();
+
   al_destroy_font(fonts[0]);
   al_destroy_font(fonts[1]);
   al_destroy_font(fonts[2]);
   al_destroy_font(fonts[3]);
   al_destroy_font(fonts[4]);
 
-  for (i = 0; i < 12; ++i)
+  for (i = 0; i < num_images; ++i)
     al_destroy_bitmap(images[i]);
 
-  for (i = 0; i < 7; ++i)
+  if (song_stream)
+    al_destroy_audio_stream(song_stream);
+
+  DestroyVoices();
+
+  for (i = 0; i < num_sounds; ++i)
     al_destroy_sample(sounds[i]);
 
-  al_destroy_bitmap(player.sprite);
-  al_destroy_bitmap(cam.screen);
-}
\ No newline at end of file
+  //Sub-bitmaps of the atlas have to go before it does
+  al_destroy_bitmap(platform_strip);
+  al_destroy_bitmap(atlas);
+
+  al_destroy_bitmap(load_bitmap);
+  al_destroy_bitmap(cam_screen);
+  al_destroy_bitmap(freeze_frame);
+}
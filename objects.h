@@ -1,3 +1,6 @@
+#ifndef OBJECTS_H
+#define OBJECTS_H
+
 enum pickup_types {COIN, STAR};
 
 struct Point
@@ -31,6 +34,7 @@ struct Player
   float gravity;
 
   int health;
+  int invulnerable; //Ticks left before an enemy can hurt the player again
 
   enum states{WALKING, FALLING, JUMPING};
   int state;
@@ -38,8 +42,6 @@ struct Player
   enum animations{STAND, RUN, SKID, JUMP};
   enum directions{LEFT, RIGHT};
   
-  
-  ALLEGRO_BITMAP *sheet[7];
   int frames[4];
 
   int current_animation;
@@ -50,66 +52,19 @@ struct Player
   float scale_y;
   float rotation;
 
-  ALLEGRO_BITMAP *sprite;
-
   Rect hitbox;
 
   Point bottom_left;
   Point bottom_right;
 };
 
-struct Platform
-{
-  int x;
-  int y;
-  int width;
-  int height;
-
-  bool alive;
-
-  enum type{NORMAL};
-  int type;
-
-  int position;
-
-  Rect hitbox;
-
-  ALLEGRO_BITMAP *sprite;
-};
-
 struct Camera
 {
   int x;
   int y;
   int width;
   int height;
-  ALLEGRO_BITMAP *screen;
   Point last;
 };
 
-struct Pickup
-{
-  int x;
-  int y;
-  int type;
-  bool alive;
-  ALLEGRO_BITMAP *sheet;
-  int frame_count;
-  int current_frame;
-  int delay;
-  int frames;
-  Rect hitbox;
-};
-
-struct Enemy
-{
-  int x;
-  int y;
-  bool alive;
-  ALLEGRO_BITMAP *sheet;
-  int frame_count;
-  int current_frame;
-  int delay;
-  int frames;
-  Rect hitbox;
-};
\ No newline at end of file
+#endif
@@ -0,0 +1,179 @@
+#include <cstring>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "pack.h"
+
+static unsigned int ReadU16(const unsigned char *data)
+{
+  return (unsigned int)data[0] | ((unsigned int)data[1] << 8);
+}
+
+static unsigned int ReadU32(const unsigned char *data)
+{
+  return ReadU16(data) | (ReadU16(data + 2) << 16);
+}
+
+//Maps the whole file read only, returns NULL if it can't
+static const unsigned char *MapFile(const char *path, size_t &size)
+{
+#ifdef _WIN32
+  HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+
+  if (file == INVALID_HANDLE_VALUE)
+    return NULL;
+
+  LARGE_INTEGER length;
+  HANDLE mapping = NULL;
+  void *data = NULL;
+
+  if (GetFileSizeEx(file, &length) && length.QuadPart > 0)
+    mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+
+  //The view keeps the file open on its own
+  if (mapping)
+  {
+    data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(mapping);
+  }
+
+  CloseHandle(file);
+
+  size = data ? (size_t)length.QuadPart : 0;
+  return (const unsigned char *)data;
+#else
+  int file = open(path, O_RDONLY);
+
+  if (file < 0)
+    return NULL;
+
+  struct stat info;
+  void *data = MAP_FAILED;
+
+  if (fstat(file, &info) == 0 && info.st_size > 0)
+    data = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+
+  //The mapping keeps the file open on its own
+  close(file);
+
+  if (data == MAP_FAILED)
+    return NULL;
+
+  size = info.st_size;
+  return (const unsigned char *)data;
+#endif
+}
+
+static void UnmapFile(const unsigned char *data, size_t size)
+{
+#ifdef _WIN32
+  UnmapViewOfFile(data);
+#else
+  munmap((void *)data, size);
+#endif
+}
+
+bool OpenPack(Pack &pack, const char *path)
+{
+  pack.data = MapFile(path, pack.size);
+  pack.count = 0;
+  pack.index = NULL;
+
+  if (!pack.data)
+    return false;
+
+  if (pack.size < 8 || memcmp(pack.data, "TCPK", 4) != 0 || ReadU16(pack.data + 4) != pack_version)
+  {
+    ClosePack(pack);
+    return false;
+  }
+
+  pack.count = ReadU16(pack.data + 6);
+  pack.index = pack.data + 8;
+
+  //Check every entry fits in the file now, so FindInPack doesn't have to
+  const unsigned char *entry = pack.index;
+  const unsigned char *end = pack.data + pack.size;
+
+  for (int i = 0; i < pack.count; ++i)
+  {
+    if (entry + 2 > end || entry + 2 + entry[1] + 8 > end)
+    {
+      ClosePack(pack);
+      return false;
+    }
+
+    const unsigned char *location = entry + 2 + entry[1];
+    unsigned int offset = ReadU32(location);
+    unsigned int size = ReadU32(location + 4);
+
+    if (offset > pack.size || size > pack.size - offset)
+    {
+      ClosePack(pack);
+      return false;
+    }
+
+    entry = location + 8;
+  }
+
+  return true;
+}
+
+void ClosePack(Pack &pack)
+{
+  if (pack.data)
+    UnmapFile(pack.data, pack.size);
+
+  pack.data = NULL;
+  pack.size = 0;
+  pack.count = 0;
+  pack.index = NULL;
+}
+
+bool FindInPack(const Pack &pack, const char *name, const void *&data, size_t &size)
+{
+  size_t length = strlen(name);
+  const unsigned char *entry = pack.index;
+
+  for (int i = 0; i < pack.count; ++i)
+  {
+    const unsigned char *location = entry + 2 + entry[1];
+
+    if (entry[1] == length && memcmp(entry + 2, name, length) == 0)
+    {
+      data = pack.data + ReadU32(location);
+      size = ReadU32(location + 4);
+      return true;
+    }
+
+    entry = location + 8;
+  }
+
+  return false;
+}
+
+int PackTypeFor(const char *name)
+{
+  const char *extension = strrchr(name, '.');
+
+  if (!extension)
+    return PACK_OTHER;
+
+  if (strcmp(extension, ".png") == 0)
+    return PACK_BITMAP;
+
+  if (strcmp(extension, ".ttf") == 0)
+    return PACK_FONT;
+
+  if (strcmp(extension, ".wav") == 0 || strcmp(extension, ".ogg") == 0)
+    return PACK_SAMPLE;
+
+  return PACK_OTHER;
+}
@@ -0,0 +1,38 @@
+//Asset pack, every file the game loads stuck together in one file with an index at the front.
+//The game maps the whole pack in to memory and loads from there, so starting up is one open instead of one per file.
+//Build one with tools/packer.cpp.
+//
+//File format, all little endian:
+//  "TCPK"          magic
+//  u16 version     pack_version
+//  u16 count       number of files
+//  then count of   u8 type, u8 name length, name, u32 offset, u32 size    offset is from the start of the pack
+//  then the files
+
+#ifndef PACK_H
+#define PACK_H
+
+#include <cstddef>
+
+const int pack_version = 1;
+
+//What kind of file an entry is, worked out from its extension when the pack is built
+enum PACK_TYPES{PACK_OTHER, PACK_BITMAP, PACK_FONT, PACK_SAMPLE};
+
+struct Pack
+{
+  const unsigned char *data; //The whole file, NULL if nothing is open
+  size_t size;
+  int count;
+  const unsigned char *index; //First entry in the index
+};
+
+bool OpenPack(Pack &pack, const char *path); //Maps the pack at path in to memory, returns false if it's missing or broken
+void ClosePack(Pack &pack); //Unmaps the pack, nothing loaded from it can be used after this
+
+//Finds the file called name and points data and size at it, returns false if it isn't in the pack
+bool FindInPack(const Pack &pack, const char *name, const void *&data, size_t &size);
+
+int PackTypeFor(const char *name); //Returns the type a file gets going by its extension
+
+#endif
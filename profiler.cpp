@@ -0,0 +1,224 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/resource.h>
+#endif
+
+#include "profiler.h"
+
+using namespace std;
+
+const char *profile_names[num_profile_sections] =
+{
+  "Update",
+  "UpdatePlatforms",
+  "UpdatePickups",
+  "UpdateEnemies",
+  "UpdatePlayer",
+  "Draw",
+  "DrawBackground",
+  "DrawPlatforms",
+  "DrawPickups",
+  "DrawEnemies",
+  "DrawPlayer",
+  "DrawBatch",
+  "DrawHUD",
+  "Flip",
+  "Frame"
+};
+
+bool profiling = false;
+
+//Whole run timings are bucketed in tenths of a microsecond, exactly below 32 and then 16 buckets per doubling.
+//27 doublings covers up to about 13 seconds which is plenty for one frame
+const int histogram_buckets = 32 + 22 * 16;
+
+struct ProfileSection
+{
+  double window[profile_window]; //Ring buffer of the latest timings
+  int next; //Where the next timing goes in window
+  int count; //How many of window are filled
+
+  long long calls;
+  double total;
+  double min;
+  double max;
+  long long histogram[histogram_buckets];
+};
+
+static ProfileSection sections[num_profile_sections];
+
+static int Bucket(double ms)
+{
+  unsigned int v = (unsigned int)min(ms * 10000, 4e9);
+
+  if (v < 32)
+    return v;
+
+  int e = 5;
+  while ((v >> (e + 1)) != 0)
+    ++e;
+
+  int bucket = 32 + (e - 5) * 16 + ((v >> (e - 4)) & 15);
+  return bucket < histogram_buckets ? bucket : histogram_buckets - 1;
+}
+
+//Time in ms at the middle of a bucket
+static double BucketValue(int bucket)
+{
+  if (bucket < 32)
+    return bucket / 10000.0;
+
+  int e = 5 + (bucket - 32) / 16;
+  int sub = (bucket - 32) % 16;
+  double low = (double)((16 + sub) << (e - 4));
+  double high = (double)((17 + sub) << (e - 4));
+
+  return (low + high) / 2 / 10000.0;
+}
+
+double ProfileNow()
+{
+  return chrono::duration<double, milli>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+double ProcessCpuTime()
+{
+#ifdef _WIN32
+  FILETIME created, exited, kernel, user;
+
+  if (!GetProcessTimes(GetCurrentProcess(), &created, &exited, &kernel, &user))
+    return 0;
+
+  //In 100 nanosecond units
+  unsigned long long total = ((unsigned long long)kernel.dwHighDateTime << 32 | kernel.dwLowDateTime) +
+                             ((unsigned long long)user.dwHighDateTime << 32 | user.dwLowDateTime);
+  return total / 1e7;
+#else
+  struct rusage usage;
+
+  if (getrusage(RUSAGE_SELF, &usage) != 0)
+    return 0;
+
+  return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+#endif
+}
+
+void AddProfileSample(int section, double ms)
+{
+  ProfileSection &s = sections[section];
+
+  s.window[s.next] = ms;
+  s.next = (s.next + 1) % profile_window;
+  if (s.count < profile_window)
+    ++s.count;
+
+  if (s.calls == 0 || ms < s.min)
+    s.min = ms;
+  if (s.calls == 0 || ms > s.max)
+    s.max = ms;
+
+  ++s.calls;
+  s.total += ms;
+  ++s.histogram[Bucket(ms)];
+}
+
+void ProfileSpan(int section, double start, double end)
+{
+  if (profiling)
+    AddProfileSample(section, end - start);
+
+  if (tracing)
+    TraceComplete(profile_names[section], start * 1000, (end - start) * 1000);
+}
+
+ProfileStats GetProfileStats(int section)
+{
+  const ProfileSection &s = sections[section];
+  ProfileStats stats = {0, 0, 0, 0, 0};
+
+  if (s.count == 0)
+    return stats;
+
+  double sorted[profile_window];
+  double total = 0;
+
+  copy(s.window, s.window + s.count, sorted);
+
+  stats.calls = s.count;
+  stats.min = sorted[0];
+  stats.max = sorted[0];
+
+  for (int i = 0; i < s.count; ++i)
+  {
+    total += sorted[i];
+    stats.min = min(stats.min, sorted[i]);
+    stats.max = max(stats.max, sorted[i]);
+  }
+
+  stats.avg = total / s.count;
+
+  int p99 = (s.count * 99 + 99) / 100 - 1;
+  nth_element(sorted, sorted + p99, sorted + s.count);
+  stats.p99 = sorted[p99];
+
+  return stats;
+}
+
+ProfileStats GetProfileTotals(int section)
+{
+  const ProfileSection &s = sections[section];
+  ProfileStats stats = {0, 0, 0, 0, 0};
+
+  if (s.calls == 0)
+    return stats;
+
+  stats.calls = s.calls;
+  stats.min = s.min;
+  stats.max = s.max;
+  stats.avg = s.total / s.calls;
+
+  //Walk the histogram until we've passed 99% of the calls
+  long long target = (s.calls * 99 + 99) / 100;
+  long long seen = 0;
+
+  for (int i = 0; i < histogram_buckets; ++i)
+  {
+    seen += s.histogram[i];
+
+    if (seen >= target)
+    {
+      stats.p99 = min(BucketValue(i), s.max);
+      break;
+    }
+  }
+
+  return stats;
+}
+
+bool WriteProfileCSV(const char *path)
+{
+  FILE *file = fopen(path, "w");
+
+  if (!file)
+    return false;
+
+  fprintf(file, "section,calls,total_ms,min_ms,avg_ms,p99_ms,max_ms,recent_calls,recent_min_ms,recent_avg_ms,recent_p99_ms,recent_max_ms\n");
+
+  for (int i = 0; i < num_profile_sections; ++i)
+  {
+    ProfileStats totals = GetProfileTotals(i);
+    ProfileStats recent = GetProfileStats(i);
+
+    fprintf(file, "%s,%lld,%.3f,%.4f,%.4f,%.4f,%.4f,%lld,%.4f,%.4f,%.4f,%.4f\n", profile_names[i],
+      totals.calls, sections[i].total, totals.min, totals.avg, totals.p99, totals.max,
+      recent.calls, recent.min, recent.avg, recent.p99, recent.max);
+  }
+
+  fclose(file);
+  return true;
+}
@@ -0,0 +1,77 @@
+//Scoped timers for each part of the game loop.
+//Every timing goes in to a rolling window for the on screen overlay and a histogram covering the whole run for the csv dump.
+//Nothing is recorded until profiling is set to true, so neither the game nor the headless runner pays for it unless
+//asked. The game turns it on with -profile or while the F1 overlay is open.
+//While tracing is on every timed section also goes in to the trace timeline, see trace.h.
+
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include "trace.h"
+
+enum PROFILE_SECTIONS
+{
+  PROFILE_UPDATE, //One whole simulation step
+  PROFILE_UPDATE_PLATFORMS,
+  PROFILE_UPDATE_PICKUPS,
+  PROFILE_UPDATE_ENEMIES,
+  PROFILE_UPDATE_PLAYER,
+  PROFILE_DRAW, //Everything in Draw up to the flip
+  PROFILE_DRAW_BACKGROUND,
+  PROFILE_DRAW_PLATFORMS,
+  PROFILE_DRAW_PICKUPS,
+  PROFILE_DRAW_ENEMIES,
+  PROFILE_DRAW_PLAYER,
+  PROFILE_DRAW_BATCH, //Sending the held sprite batch to the gpu
+  PROFILE_DRAW_HUD,
+  PROFILE_FLIP, //al_flip_display
+  PROFILE_FRAME, //Time from one flip to the next
+  num_profile_sections
+};
+
+//Names for each section, used in the overlay and the csv
+extern const char *profile_names[num_profile_sections];
+
+//Number of timings kept per section for the rolling stats, 10 seconds worth at 60fps
+const int profile_window = 600;
+
+//Set to true to start recording
+extern bool profiling;
+
+struct ProfileStats
+{
+  long long calls;
+  double min; //All times are in milliseconds
+  double avg;
+  double p99;
+  double max;
+};
+
+double ProfileNow(); //Current time in milliseconds, only useful for differences
+double ProcessCpuTime(); //Seconds of CPU time used by every thread in the process so far
+void AddProfileSample(int section, double ms); //Records one timing for section
+void ProfileSpan(int section, double start, double end); //Records section running from start to end in the profiler and the trace, whichever are on
+
+//Times from construction to the end of the scope and records it under section.
+//Inline so that with profiling and tracing off it costs no more than a check
+struct ProfileScope
+{
+  int section;
+  double start;
+
+  ProfileScope(int section) : section(section), start(profiling || tracing ? ProfileNow() : 0) {}
+
+  ~ProfileScope()
+  {
+    if (profiling || tracing)
+      ProfileSpan(section, start, ProfileNow());
+  }
+};
+
+#define PROFILE_SCOPE(section) ProfileScope profile_scope_##section(section)
+
+ProfileStats GetProfileStats(int section); //Stats over the last profile_window timings
+ProfileStats GetProfileTotals(int section); //Stats over the whole run, p99 is approximate
+bool WriteProfileCSV(const char *path); //Writes the rolling and whole run stats for every section, returns false if it can't
+
+#endif
@@ -0,0 +1,153 @@
+#include <cstring>
+
+#include "replay.h"
+#include "simulation.h"
+
+static void WriteU16(FILE *file, unsigned int value)
+{
+  fputc(value & 0xff, file);
+  fputc((value >> 8) & 0xff, file);
+}
+
+static void WriteU32(FILE *file, unsigned int value)
+{
+  WriteU16(file, value & 0xffff);
+  WriteU16(file, (value >> 16) & 0xffff);
+}
+
+static bool ReadU16(FILE *file, unsigned int &value)
+{
+  int lo = fgetc(file);
+  int hi = fgetc(file);
+
+  if (lo == EOF || hi == EOF)
+    return false;
+
+  value = (unsigned int)lo | ((unsigned int)hi << 8);
+  return true;
+}
+
+static bool ReadU32(FILE *file, unsigned int &value)
+{
+  unsigned int lo, hi;
+
+  if (!ReadU16(file, lo) || !ReadU16(file, hi))
+    return false;
+
+  value = lo | (hi << 16);
+  return true;
+}
+
+bool StartRecording(ReplayRecorder &recorder, const char *path, unsigned int seed)
+{
+  recorder.file = fopen(path, "wb");
+  recorder.mask = 0;
+  recorder.run = 0;
+  recorder.ticks = 0;
+
+  if (!recorder.file)
+    return false;
+
+  fwrite("TCRP", 1, 4, recorder.file);
+  WriteU16(recorder.file, replay_version);
+  WriteU16(recorder.file, num_keys);
+  WriteU32(recorder.file, seed);
+  WriteU32(recorder.file, 0); //Filled in by StopRecording
+
+  return true;
+}
+
+void RecordTick(ReplayRecorder &recorder, unsigned int keys)
+{
+  if (!recorder.file)
+    return;
+
+  keys &= 0xffff;
+
+  //Input hardly ever changes from one tick to the next so only write it out when it does
+  if (recorder.run > 0 && (keys != recorder.mask || recorder.run == 0xffff))
+  {
+    WriteU16(recorder.file, recorder.mask);
+    WriteU16(recorder.file, recorder.run);
+    recorder.run = 0;
+  }
+
+  recorder.mask = keys;
+  ++recorder.run;
+  ++recorder.ticks;
+}
+
+void StopRecording(ReplayRecorder &recorder)
+{
+  if (!recorder.file)
+    return;
+
+  if (recorder.run > 0)
+  {
+    WriteU16(recorder.file, recorder.mask);
+    WriteU16(recorder.file, recorder.run);
+  }
+
+  fseek(recorder.file, 12, SEEK_SET);
+  WriteU32(recorder.file, recorder.ticks);
+
+  fclose(recorder.file);
+  recorder.file = NULL;
+}
+
+bool StartPlayback(ReplayPlayer &replay, const char *path)
+{
+  char magic[4];
+  unsigned int version, keys;
+
+  replay.file = fopen(path, "rb");
+  replay.seed = 0;
+  replay.ticks = 0;
+  replay.played = 0;
+  replay.mask = 0;
+  replay.run = 0;
+
+  if (!replay.file)
+    return false;
+
+  if (fread(magic, 1, 4, replay.file) != 4 || memcmp(magic, "TCRP", 4) != 0 ||
+      !ReadU16(replay.file, version) || version != replay_version ||
+      !ReadU16(replay.file, keys) || keys != num_keys ||
+      !ReadU32(replay.file, replay.seed) || !ReadU32(replay.file, replay.ticks))
+  {
+    StopPlayback(replay);
+    return false;
+  }
+
+  return true;
+}
+
+bool NextTick(ReplayPlayer &replay, unsigned int &keys)
+{
+  if (!replay.file || replay.played >= replay.ticks)
+    return false;
+
+  if (replay.run == 0)
+  {
+    if (!ReadU16(replay.file, replay.mask) || !ReadU16(replay.file, replay.run) || replay.run == 0)
+    {
+      StopPlayback(replay);
+      return false;
+    }
+  }
+
+  keys = replay.mask;
+  --replay.run;
+  ++replay.played;
+
+  return true;
+}
+
+void StopPlayback(ReplayPlayer &replay)
+{
+  if (replay.file)
+  {
+    fclose(replay.file);
+    replay.file = NULL;
+  }
+}
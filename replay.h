@@ -0,0 +1,45 @@
+//Recording and playback of the input mask fed to StepGame each tick.
+//The simulation is deterministic so a seed plus the input for every tick is enough to replay a whole session.
+//
+//File format, all little endian:
+//  "TCRP"          magic
+//  u16 version     replay_version
+//  u16 num_keys    bits used in each mask
+//  u32 seed        passed to InitGame
+//  u32 ticks       total number of ticks recorded
+//  then runs of    u16 mask, u16 count    the same mask held for count ticks
+
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include <cstdio>
+
+const int replay_version = 1;
+
+struct ReplayRecorder
+{
+  FILE *file;
+  unsigned int mask; //Mask of the run currently being counted
+  unsigned int run; //How many ticks the current mask has been held for
+  unsigned int ticks;
+};
+
+struct ReplayPlayer
+{
+  FILE *file;
+  unsigned int seed;
+  unsigned int ticks; //Total ticks in the file
+  unsigned int played; //Ticks handed out so far
+  unsigned int mask;
+  unsigned int run; //Ticks left on the current mask
+};
+
+bool StartRecording(ReplayRecorder &recorder, const char *path, unsigned int seed); //Opens path and writes the header, returns false if it can't be opened
+void RecordTick(ReplayRecorder &recorder, unsigned int keys); //Adds one tick of input
+void StopRecording(ReplayRecorder &recorder); //Writes the last run, fills in the tick count and closes the file
+
+bool StartPlayback(ReplayPlayer &replay, const char *path); //Opens path and reads the header, replay.seed is what to pass to InitGame
+bool NextTick(ReplayPlayer &replay, unsigned int &keys); //Gets the input for the next tick, returns false once the replay has finished
+void StopPlayback(ReplayPlayer &replay);
+
+#endif
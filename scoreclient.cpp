@@ -0,0 +1,520 @@
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#include <windows.h>
+typedef SOCKET Socket;
+#else
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <unistd.h>
+typedef int Socket;
+const Socket INVALID_SOCKET = -1;
+#endif
+
+//A server hanging up part way through a request would otherwise raise SIGPIPE and take the whole game down with it.
+//Linux says so per send, macOS per socket, see Connect. Windows never raises it
+#ifdef MSG_NOSIGNAL
+const int send_flags = MSG_NOSIGNAL;
+#else
+const int send_flags = 0;
+#endif
+
+#include "files.h"
+#include "scoreclient.h"
+#include "trace.h"
+
+using namespace std;
+
+typedef chrono::steady_clock Clock;
+
+//Longest to wait to connect, or for the server to take or answer a request
+const int score_timeout = 5;
+
+struct QueuedScore
+{
+  unsigned long long id; //Goes up by one for each score queued, so a batch can be found again once it's been sent
+  char name[4];
+  unsigned int score;
+  unsigned int when;
+};
+
+static thread worker;
+static mutex queue_lock;
+static condition_variable wake;
+
+//Everything below is only touched with queue_lock held
+static deque<QueuedScore> queue;
+static unsigned long long next_id = 1;
+static bool running = false;
+static bool stopping = false;
+static bool spool_dirty = false; //The queue has changed since the spool was last written
+static Clock::time_point retry_at;
+static ScoreClientStats stats;
+static long long latency_count = 0;
+
+//Set before the worker starts and not changed after
+static string host;
+static string port;
+static string path;
+static string spool_path;
+
+//Where host:port was last found, only touched by the worker. Looked up again after failing to connect to any of them
+static addrinfo *resolved = NULL;
+
+//A lookup of host:port running on a thread of its own, so a slow or missing DNS server can be given up on instead of
+//holding up the worker, and through it closing the game. It's shared with that thread and freed by whichever of the
+//two is done with it last
+struct Lookup
+{
+  mutex lock;
+  condition_variable finished;
+  bool done;
+  int result;
+  addrinfo *addresses; //Whatever the worker didn't take, freed with the lookup
+  string host;
+  string port;
+
+  Lookup() : done(false), result(0), addresses(NULL) {}
+
+  ~Lookup()
+  {
+    if (addresses)
+      freeaddrinfo(addresses);
+  }
+};
+
+//One line per score, the same as they're sent
+static string FormatScores(const vector<QueuedScore> &scores)
+{
+  string text;
+
+  for (size_t i = 0; i < scores.size(); ++i)
+  {
+    char line[64];
+    snprintf(line, sizeof(line), "%s %u %u\n", scores[i].name, scores[i].score, scores[i].when);
+    text += line;
+  }
+
+  return text;
+}
+
+//Writes a new spool and renames it over the old one, so closing part way through can't lose what was there
+static void WriteSpool(const vector<QueuedScore> &scores)
+{
+  TRACE_SCOPE("WriteSpool");
+
+  string temp_path = spool_path + ".new";
+  FILE *file = fopen(temp_path.c_str(), "wb");
+
+  if (!file)
+    return;
+
+  string text = FormatScores(scores);
+  bool ok = fwrite(text.data(), 1, text.size(), file) == text.size();
+
+  ok = SyncFile(file) && ok;
+  ok = fclose(file) == 0 && ok;
+
+  if (!ok || !RenameOver(temp_path.c_str(), spool_path.c_str(), true))
+    remove(temp_path.c_str());
+}
+
+static void CloseSocket(Socket socket)
+{
+#ifdef _WIN32
+  closesocket(socket);
+#else
+  close(socket);
+#endif
+}
+
+static void SetBlocking(Socket socket, bool blocking)
+{
+#ifdef _WIN32
+  u_long mode = blocking ? 0 : 1;
+  ioctlsocket(socket, FIONBIO, &mode);
+#else
+  int flags = fcntl(socket, F_GETFL, 0);
+  fcntl(socket, F_SETFL, blocking ? (flags & ~O_NONBLOCK) : (flags | O_NONBLOCK));
+#endif
+}
+
+static void RunLookup(shared_ptr<Lookup> lookup)
+{
+  addrinfo hints;
+  addrinfo *addresses = NULL;
+
+  memset(&hints, 0, sizeof(hints));
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+
+  int result = getaddrinfo(lookup->host.c_str(), lookup->port.c_str(), &hints, &addresses);
+
+  lock_guard<mutex> lock(lookup->lock);
+  lookup->result = result;
+  lookup->addresses = result == 0 ? addresses : NULL;
+  lookup->done = true;
+  lookup->finished.notify_one();
+}
+
+//Looks up host:port if it hasn't been already, giving up after score_timeout. Returns NULL if it couldn't.
+//A lookup that's given up on is left to finish on its own, getaddrinfo can't be stopped part way
+static addrinfo *Resolve()
+{
+  if (resolved)
+    return resolved;
+
+  TRACE_SCOPE("Resolve");
+
+  shared_ptr<Lookup> lookup = make_shared<Lookup>();
+  lookup->host = host;
+  lookup->port = port;
+
+  thread(RunLookup, lookup).detach();
+
+  unique_lock<mutex> lock(lookup->lock);
+
+  if (lookup->finished.wait_for(lock, chrono::seconds(score_timeout), [&lookup]{ return lookup->done; }) && lookup->result == 0)
+  {
+    resolved = lookup->addresses;
+    lookup->addresses = NULL;
+  }
+
+  return resolved;
+}
+
+//Connects to host:port giving up after score_timeout for the lookup and again for each address, returns
+//INVALID_SOCKET if it couldn't
+static Socket Connect()
+{
+  addrinfo *addresses = Resolve();
+
+  if (!addresses)
+    return INVALID_SOCKET;
+
+  Socket connected = INVALID_SOCKET;
+
+  for (addrinfo *address = addresses; address && connected == INVALID_SOCKET; address = address->ai_next)
+  {
+    Socket s = socket(address->ai_family, address->ai_socktype, address->ai_protocol);
+
+    if (s == INVALID_SOCKET)
+      continue;
+
+    //Connect without blocking so it can be given up on, a blocking connect can take minutes to fail
+    SetBlocking(s, false);
+
+    if (connect(s, address->ai_addr, (int)address->ai_addrlen) != 0)
+    {
+#ifdef _WIN32
+      bool waiting = WSAGetLastError() == WSAEWOULDBLOCK;
+#else
+      bool waiting = errno == EINPROGRESS;
+#endif
+      fd_set writable;
+      timeval timeout = {score_timeout, 0};
+      int error = 0;
+      socklen_t length = sizeof(error);
+
+      FD_ZERO(&writable);
+      FD_SET(s, &writable);
+
+      if (!waiting || select((int)s + 1, NULL, &writable, NULL, &timeout) != 1 ||
+          getsockopt(s, SOL_SOCKET, SO_ERROR, (char *)&error, &length) != 0 || error != 0)
+      {
+        CloseSocket(s);
+        continue;
+      }
+    }
+
+    SetBlocking(s, true);
+
+#ifdef SO_NOSIGPIPE
+    int no_sigpipe = 1;
+    setsockopt(s, SOL_SOCKET, SO_NOSIGPIPE, &no_sigpipe, sizeof(no_sigpipe));
+#endif
+
+#ifdef _WIN32
+    DWORD timeout = score_timeout * 1000;
+#else
+    timeval timeout = {score_timeout, 0};
+#endif
+    setsockopt(s, SOL_SOCKET, SO_RCVTIMEO, (const char *)&timeout, sizeof(timeout));
+    setsockopt(s, SOL_SOCKET, SO_SNDTIMEO, (const char *)&timeout, sizeof(timeout));
+
+    connected = s;
+  }
+
+  //The server may have moved
+  if (connected == INVALID_SOCKET)
+  {
+    freeaddrinfo(resolved);
+    resolved = NULL;
+  }
+
+  return connected;
+}
+
+static bool SendAll(Socket socket, const string &data)
+{
+  size_t sent = 0;
+
+  while (sent < data.size())
+  {
+    int result = send(socket, data.data() + sent, (int)(data.size() - sent), send_flags);
+
+    if (result <= 0)
+      return false;
+
+    sent += result;
+  }
+
+  return true;
+}
+
+//Posts one batch, returns true if the server said it took it
+static bool PostScores(const vector<QueuedScore> &batch)
+{
+  TRACE_SCOPE("PostScores");
+
+  string body = FormatScores(batch);
+  char header[512];
+
+  snprintf(header, sizeof(header),
+    "POST %s HTTP/1.0\r\nHost: %s\r\nContent-Type: text/plain\r\nContent-Length: %u\r\nConnection: close\r\n\r\n",
+    path.c_str(), host.c_str(), (unsigned int)body.size());
+
+  Socket s = Connect();
+
+  if (s == INVALID_SOCKET)
+    return false;
+
+  bool ok = SendAll(s, header) && SendAll(s, body);
+
+  //Only the status line matters, "HTTP/1.x 2xx"
+  char reply[16];
+  int received = 0;
+
+  while (ok && received < 12)
+  {
+    int result = recv(s, reply + received, 12 - received, 0);
+
+    if (result <= 0)
+      break;
+
+    received += result;
+  }
+
+  CloseSocket(s);
+
+  return ok && received >= 12 && memcmp(reply, "HTTP/1.", 7) == 0 && reply[9] == '2';
+}
+
+static void SendScores()
+{
+  unique_lock<mutex> lock(queue_lock);
+  double backoff = 0;
+
+  for (;;)
+  {
+    //Sleep until there's something to send and it's time to try, the spool needs writing, or it's time to stop
+    while (!stopping && !spool_dirty && (queue.empty() || Clock::now() < retry_at))
+    {
+      if (queue.empty())
+        wake.wait(lock);
+      else
+        wake.wait_until(lock, retry_at);
+    }
+
+    if (spool_dirty)
+    {
+      vector<QueuedScore> scores(queue.begin(), queue.end());
+      spool_dirty = false;
+
+      lock.unlock();
+      WriteSpool(scores);
+      lock.lock();
+      continue;
+    }
+
+    if (stopping)
+      break;
+
+    //The batch stays in the queue until it's been taken, so it's still in the spool if the game closes
+    vector<QueuedScore> batch(queue.begin(), queue.begin() + min((int)queue.size(), score_batch_size));
+
+    lock.unlock();
+
+    Clock::time_point start = Clock::now();
+    bool sent = PostScores(batch);
+    Clock::time_point end = Clock::now();
+
+    lock.lock();
+
+    if (sent)
+    {
+      //Anything in the batch that's still there, some may have been dropped to make room while it was sending
+      while (!queue.empty() && queue.front().id <= batch.back().id)
+        queue.pop_front();
+
+      double latency = chrono::duration<double, milli>(end - start).count();
+
+      stats.sent += batch.size();
+      stats.last_latency = latency;
+      stats.avg_latency += (latency - stats.avg_latency) / ++latency_count;
+
+      backoff = 0;
+      retry_at = end;
+      spool_dirty = true;
+    }
+    else
+    {
+      ++stats.failures;
+
+      backoff = backoff == 0 ? score_retry_min : min(backoff * 2, score_retry_max);
+      retry_at = end + chrono::duration_cast<Clock::duration>(chrono::duration<double>(backoff));
+    }
+  }
+}
+
+//Queues whatever was left in the spool last time, before the worker starts
+static void ReadSpool()
+{
+  FILE *file = fopen(spool_path.c_str(), "rb");
+
+  if (!file)
+    return;
+
+  QueuedScore score;
+  char name[8];
+
+  while (fscanf(file, "%7s %u %u", name, &score.score, &score.when) == 3)
+  {
+    strncpy(score.name, name, 3);
+    score.name[3] = '\0';
+    score.id = next_id++;
+
+    if ((int)queue.size() >= max_queued_scores)
+      queue.pop_front();
+
+    queue.push_back(score);
+  }
+
+  fclose(file);
+}
+
+bool StartScoreClient(const char *new_host, const char *new_port, const char *new_path, const char *new_spool_path)
+{
+#ifdef _WIN32
+  WSADATA data;
+
+  if (WSAStartup(MAKEWORD(2, 2), &data) != 0)
+    return false;
+#endif
+
+  host = new_host;
+  port = new_port;
+  path = new_path;
+  spool_path = new_spool_path;
+
+  memset(&stats, 0, sizeof(stats));
+  latency_count = 0;
+
+  ReadSpool();
+
+  running = true;
+  stopping = false;
+  retry_at = Clock::now();
+
+  worker = thread(SendScores);
+  return true;
+}
+
+void QueueScore(const char *name, unsigned int score, unsigned int when)
+{
+  {
+    lock_guard<mutex> lock(queue_lock);
+
+    if (!running)
+      return;
+
+    QueuedScore queued;
+    strncpy(queued.name, name, 3);
+    queued.name[3] = '\0';
+    queued.score = score;
+    queued.when = when;
+    queued.id = next_id++;
+
+    if ((int)queue.size() >= max_queued_scores)
+    {
+      queue.pop_front();
+      ++stats.dropped;
+    }
+
+    queue.push_back(queued);
+    spool_dirty = true;
+  }
+
+  wake.notify_one();
+}
+
+ScoreClientStats GetScoreClientStats()
+{
+  lock_guard<mutex> lock(queue_lock);
+
+  ScoreClientStats current = stats;
+  current.queued = queue.size();
+  current.retry_in = 0;
+
+  Clock::time_point now = Clock::now();
+
+  if (!queue.empty() && retry_at > now)
+    current.retry_in = chrono::duration<double>(retry_at - now).count();
+
+  return current;
+}
+
+void StopScoreClient()
+{
+  {
+    lock_guard<mutex> lock(queue_lock);
+
+    if (!running)
+      return;
+
+    stopping = true;
+  }
+
+  wake.notify_one();
+  worker.join();
+
+  if (resolved)
+    freeaddrinfo(resolved);
+
+  resolved = NULL;
+
+  //What's left is in the spool now, keeping it here too would send it twice if the client is started again
+  lock_guard<mutex> lock(queue_lock);
+  queue.clear();
+  spool_dirty = false;
+  running = false;
+
+#ifdef _WIN32
+  WSACleanup();
+#endif
+}
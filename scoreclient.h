@@ -0,0 +1,45 @@
+//Sends high scores to an online leaderboard as well as saving them locally, see leaderboard.h for that.
+//Scores are queued from the game without waiting and a worker thread posts them over HTTP in batches. If the
+//server can't be reached it tries again later, waiting twice as long each time up to a limit. Anything not sent
+//yet is kept in a spool file so it survives the game being closed and goes out next time.
+//
+//Each batch is one POST of text/plain with a line per score, "name score when", when in seconds since 1970.
+//Any 2xx reply means the whole batch was taken. tools/score_server.cpp is a stub server to test against.
+
+#ifndef SCORECLIENT_H
+#define SCORECLIENT_H
+
+//Most scores waiting at once, past this the oldest is dropped to make room
+const int max_queued_scores = 256;
+
+//Most scores sent in one request
+const int score_batch_size = 32;
+
+//Seconds to wait after the first failure, doubling each time up to the most
+const double score_retry_min = 1;
+const double score_retry_max = 300;
+
+struct ScoreClientStats
+{
+  int queued; //Waiting to be sent, including any in a request right now
+  long long sent;
+  long long dropped; //Pushed out of a full queue
+  long long failures; //Requests that failed and will be tried again
+  double last_latency; //Milliseconds for the last request that worked
+  double avg_latency;
+  double retry_in; //Seconds until the next try after a failure, 0 if it isn't waiting
+};
+
+//Starts sending to host:port at path, spooling to spool_path. Anything already in the spool is queued first
+bool StartScoreClient(const char *host, const char *port, const char *path, const char *spool_path);
+
+//Queues a score to send, never waits on the network or the disk. Does nothing if the client isn't running
+void QueueScore(const char *name, unsigned int score, unsigned int when);
+
+ScoreClientStats GetScoreClientStats();
+
+//Stops the worker, waiting at most as long as the request it's in the middle of, a slow address lookup included.
+//Whatever is left stays in the spool
+void StopScoreClient();
+
+#endif
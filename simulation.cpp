@@ -0,0 +1,1161 @@
+#include "simulation.h"
+#include "collision.h"
+#include "profiler.h"
+
+void InitGame(Game &game, unsigned int seed)
+{
+  int i;
+
+  game.keys = 0;
+  game.old_keys = 0;
+
+  game.current_state = MENU;
+
+  SeedRand(game, seed);
+
+  game.done = false;
+  game.paused = false;
+  game.new_game = true;
+  game.game_over = false;
+  game.scrolling = false;
+
+  game.scroll_speed = 1;
+  game.max_scroll_speed = 5;
+
+  game.highest = 0;
+  game.score = 0;
+  game.coins = 0;
+  game.zero = 0;
+
+  game.dificulty = 1;
+  game.max_dificulty = 2;
+  game.platform_increment = 96;
+
+  game.platform_spawn.x = 0;
+  game.platform_spawn.y = 0;
+
+  for (i = 0; i < 11; ++i)
+    game.platform_widths[i] = 100 + (i * 10);
+
+  game.next_width = 0;
+  game.first_platform = 0;
+  game.num_platforms = 0;
+  game.num_pickups = 0;
+
+  game.game_over_fade = 0;
+  game.game_over_fade_2 = 0;
+
+  game.coin_chance = 0;
+  game.star_chance = 0;
+  game.enemy_chance = 0;
+
+  game.num_enemies = 0;
+  game.enemy_spawns = 1;
+
+  game.submit_score = false;
+  game.name_entered = false;
+  game.submit_selection = 0;
+  game.score_name[0] = 0;
+  game.score_name[1] = 0;
+  game.score_name[2] = 0;
+
+  game.stars = 0;
+  game.allow_double_jump = false;
+  game.has_double_jumped = false;
+
+  game.menu_selection = 0;
+
+  game.play_song = false;
+  game.play_death = true;
+  game.song_state = SONG_STOPPED;
+
+  game.num_events = 0;
+
+  NewGame(game);
+}
+
+int StepGame(Game &game, unsigned int keys)
+{
+  PROFILE_SCOPE(PROFILE_UPDATE);
+
+  game.keys = keys;
+  game.num_events = 0;
+
+  if (JustPressed(game, ESCAPE))
+    game.current_state = MENU;
+
+  if (game.current_state == GAME)
+  {
+    if (game.new_game)
+    {
+      NewGame(game);
+    }
+
+    if (!game.game_over)
+    {
+      if (!game.paused)
+      {
+        if (game.play_song)
+        {
+          PlaySong(game);
+          game.play_song = false;
+        }
+
+        UpdatePlatforms(game);
+        UpdatePickups(game);
+        UpdateEnemies(game);
+        UpdatePlayer(game);
+
+        AnimatePlayer(game);
+        AnimatePickups(game);
+        AnimateEnemies(game);
+
+        //Save the state of the camera to help with the fake background scrolling
+        game.cam.last.x = game.cam.x;
+        game.cam.last.y = game.cam.y;
+
+        if ((game.player.y + game.cam.y) < HEIGHT / 4 && game.scroll_speed < 3)
+          game.cam.y += 3;
+
+        if (game.scrolling)//If the scrolling has started then move the cam by scroll_speed;
+        {
+          game.cam.y += game.scroll_speed;
+        }
+        else //Else if the player reaches the threshold start scrolling
+        {
+          if (game.player.y + game.cam.y < HEIGHT / 4)
+            game.scrolling = true;
+        }
+
+        //Keeps track of the highest point the player has reached so far
+        if (game.highest < -(game.player.y - game.zero))
+          game.highest = -(game.player.y - game.zero);
+
+        //Checks to see if player has fallen off the bottom (game over)
+        if (game.player.y + game.cam.y > HEIGHT + 100)
+          game.player.health = 0;
+
+        if (game.player.health == 0)
+          game.game_over = true;
+
+        UpdateDifficulty(game);
+
+        if (JustPressed(game, P))
+          game.paused = true;
+      }
+      else //Game is paused, update pause screen
+      {
+        PauseSong(game);
+
+        if (JustPressed(game, P))
+        {
+          game.play_song = true;
+          game.paused = false;
+        }
+      }
+    }
+    else //Game Over!
+    {
+      StopSong(game);
+      if (game.play_death)
+      {
+        PushEvent(game, EVENT_SOUND, SOUND_DIE);
+        game.play_death = false;
+      }
+
+      if (!game.submit_score && game.game_over_fade < 200)
+        game.game_over_fade += 10;
+
+      if (game.submit_score)
+      {
+        if (!game.name_entered)
+        {
+          if (JustPressed(game, LEFT))
+          {
+            if (game.submit_selection == 0)
+            {
+              game.submit_selection = 2;
+            }
+            else
+            {
+              --game.submit_selection;
+            }
+          }
+
+          if (JustPressed(game, RIGHT))
+          {
+            if (game.submit_selection == 2)
+            {
+              game.submit_selection = 0;
+            }
+            else
+            {
+              ++game.submit_selection;
+            }
+          }
+
+          if (JustPressed(game, UP))
+          {
+            if (game.score_name[game.submit_selection] == num_chars - 2)
+            {
+              game.score_name[game.submit_selection] = 0;
+            }
+            else
+            {
+              ++game.score_name[game.submit_selection];
+            }
+          }
+
+          if (JustPressed(game, DOWN))
+          {
+            if (game.score_name[game.submit_selection] == 0)
+            {
+              game.score_name[game.submit_selection] = num_chars - 2;
+            }
+            else
+            {
+              --game.score_name[game.submit_selection];
+            }
+          }
+
+          if (JustPressed(game, ENTER))
+            game.name_entered = true;
+        }
+        else //Name inputted, submit the score!
+        {
+          PushEvent(game, EVENT_SUBMIT_SCORE, (game.highest / 2) + game.score);
+          game.new_game = true;
+        }
+
+      }
+      else
+      {
+        if (JustPressed(game, S))
+          game.submit_score = true;
+      }
+    }
+
+    if (JustPressed(game, R))
+    {
+      game.new_game = true;
+    }
+  }
+  else if (game.current_state == MENU)
+  {
+    StopSong(game);
+
+    if (JustPressed(game, UP))
+    {
+      if (game.menu_selection == 0)
+      {
+        game.menu_selection = 3;
+      }
+      else
+      {
+        game.menu_selection--;
+      }
+    }
+
+    if (JustPressed(game, DOWN))
+    {
+      if (game.menu_selection == 3)
+      {
+        game.menu_selection = 0;
+      }
+      else
+      {
+        game.menu_selection++;
+      }
+    }
+
+    if (JustPressed(game, ENTER))
+    {
+      switch (game.menu_selection)
+      {
+      case 0:
+        game.play_song = true;
+        NewGame(game);
+        game.current_state = GAME;
+        break;
+      case 1:
+        game.current_state = INSTRUCTIONS;
+        break;
+      case 2:
+        game.current_state = LEADERBOARD;
+        break;
+      case 3:
+        game.done = true;
+        break;
+      }
+    }
+  }
+  else if (game.current_state == INSTRUCTIONS || game.current_state == LEADERBOARD)
+  {
+    StopSong(game);
+  }
+
+  //Copies keys into old_keys for determining JustPressed
+  game.old_keys = game.keys;
+
+  return game.num_events;
+}
+
+bool GameIdle(const Game &game)
+{
+  if (game.done)
+    return false;
+
+  if (game.current_state != GAME)
+    return game.song_state == SONG_STOPPED;
+
+  if (game.new_game)
+    return false;
+
+  if (game.game_over)
+  {
+    //Still fading in, or about to start a new game once the name is in
+    if (game.song_state != SONG_STOPPED || game.play_death || game.name_entered)
+      return false;
+
+    return game.submit_score || game.game_over_fade >= 200;
+  }
+
+  return game.paused && game.song_state != SONG_PLAYING;
+}
+
+bool KeyDown(const Game &game, int key)
+{
+  return (game.keys & (1u << key)) != 0;
+}
+
+bool JustPressed(const Game &game, int key)
+{
+  if ((game.old_keys & (1u << key)) == 0 && (game.keys & (1u << key)) != 0)
+  {
+    return true;
+  }
+  else
+  {
+    return false;
+  }
+}
+
+void InitCamera(Game &game)
+{
+  game.cam.x= 0;
+  game.cam.y = 0;
+  game.cam.last.x = 0;
+  game.cam.last.y = 0;
+  game.cam.width = WIDTH;
+  game.cam.height = HEIGHT;
+}
+
+void InitPlayer(Game &game)
+{
+  Player &player = game.player;
+
+  player.width = 32;
+  player.height = 64;
+  player.scale_x = 1;
+  player.scale_y = 1;
+  player.rotation = 0;
+  player.facing = player.RIGHT;
+
+  player.x = 10;
+  player.y = (HEIGHT - (player.height * player.scale_y)) - 25;
+
+  player.max_speed = 5;
+  player.acceleration = 0.25;
+  player.deceleration = 0.2;
+  player.speed = 0;
+
+  player.gravity = 8;
+  player.y_velocity = player.gravity;
+  player.jump_power = 19;
+
+  player.health = 3;
+  player.invulnerable = 0;
+
+  player.state = player.WALKING;
+
+  player.frames[player.STAND] = 1;
+  player.frames[player.RUN] = 2;
+  player.frames[player.SKID] = 1;
+  player.frames[player.JUMP] = 1;
+
+  player.current_frame = 0;
+  player.current_animation = player.STAND;
+  player.frame_count = 0;
+  player.delay = 6;
+
+  game.zero = HEIGHT - (player.height * player.scale_y) - 25;
+}
+
+void UpdateDifficulty(Game &game)
+{
+  if (game.dificulty < game.max_dificulty)
+  {
+    game.dificulty = float(float(float(float(game.highest / 2)) / 1000) / 10) + 1;
+  }
+  else
+  {
+    game.dificulty = game.max_dificulty;
+  }
+
+  if (game.scroll_speed < game.max_scroll_speed)
+  {
+    game.scroll_speed = float(float(float(float(game.highest / 2)) / 1000) / 2) + 1;
+  }
+  else
+  {
+    game.scroll_speed = game.max_scroll_speed;
+  }
+}
+
+void UpdatePlayer(Game &game)
+{
+  PROFILE_SCOPE(PROFILE_UPDATE_PLAYER);
+
+  Player &player = game.player;
+
+  if (player.state == player.WALKING)
+  {
+	  if (KeyDown(game, LEFT))
+    {
+      player.facing = player.LEFT;
+      if (player.speed > 0)
+      {
+        ChangePlayerAnimation(game, player.SKID, false);
+      }
+      else
+      {
+        ChangePlayerAnimation(game, player.RUN, false);
+      }
+    }
+    else if (KeyDown(game, RIGHT))
+    {
+      player.facing = player.RIGHT;
+      if (player.speed < 0)
+      {
+        ChangePlayerAnimation(game, player.SKID, false);
+      }
+      else
+      {
+        ChangePlayerAnimation(game, player.RUN, false);
+      }
+    }
+    else
+    {
+      ChangePlayerAnimation(game, player.STAND, false);
+    }
+
+    if (JustPressed(game, UP) || JustPressed(game, X))
+    {
+      player.state = player.JUMPING;
+      player.y_velocity = -player.jump_power;
+      PushEvent(game, EVENT_SOUND, SOUND_JUMP);
+    }
+  }
+
+  if (KeyDown(game, LEFT))
+  {
+    player.facing = player.LEFT;
+
+    if (player.speed <= 0)
+    {
+      player.speed -= player.acceleration;
+    }
+    else
+    {
+      player.speed -= player.deceleration;
+    }
+
+    if (player.speed < -player.max_speed)
+      player.speed = -player.max_speed;
+  }
+  else if (KeyDown(game, RIGHT))
+  {
+    player.facing = player.RIGHT;
+
+    if (player.speed >= 0)
+    {
+      player.speed += player.acceleration;
+    }
+    else
+    {
+      player.speed += player.deceleration;
+    }
+
+    if (player.speed > player.max_speed)
+      player.speed = player.max_speed;
+  }
+  else
+  {
+    if (player.speed < 0 && player.speed > -player.deceleration)
+    {
+      player.speed = 0;
+    }
+    else if (player.speed > 0 && player.speed < player.deceleration)
+    {
+      player.speed = 0;
+    }
+
+    if (player.speed < 0)
+    {
+      player.speed += player.deceleration;
+    }
+    else if (player.speed > 0)
+    {
+      player.speed -= player.deceleration;
+    }
+  }
+
+  if (KeyDown(game, LEFT))
+    {
+      if (player.speed <= 0)
+      {
+        player.speed -= player.acceleration;
+      }
+      else
+      {
+        player.speed -= player.deceleration;
+      }
+
+      if (player.speed < -player.max_speed)
+        player.speed = -player.max_speed;
+    }
+    else if (KeyDown(game, RIGHT))
+    {
+      if (player.speed >= 0)
+      {
+        player.speed += player.acceleration;
+      }
+      else
+      {
+        player.speed += player.deceleration;
+      }
+
+      if (player.speed > player.max_speed)
+        player.speed = player.max_speed;
+    }
+    else
+    {
+      if (player.speed < 0 && player.speed > -player.deceleration)
+      {
+        player.speed = 0;
+      }
+      else if (player.speed > 0 && player.speed < player.deceleration)
+      {
+        player.speed = 0;
+      }
+
+      if (player.speed < 0)
+      {
+        player.speed += player.deceleration;
+      }
+      else if (player.speed > 0)
+      {
+        player.speed -= player.deceleration;
+      }
+    }
+
+  if (player.state == player.JUMPING && !(JustPressed(game, UP) || JustPressed(game, X)))
+  {
+    ChangePlayerAnimation(game, player.JUMP, false);
+
+    game.allow_double_jump = true;
+
+    if (player.y_velocity < player.gravity)
+    {
+      player.y_velocity += 1;
+    }
+    else if (player.y_velocity >= 0)
+    {
+      player.state = player.FALLING;
+    }
+  }
+  else if (player.state == player.FALLING)
+  {
+    if (player.y_velocity < player.gravity)
+    {
+      ++player.y_velocity;
+    }
+  }
+
+  //Apply forces to player
+  player.y += player.y_velocity;
+  player.x += player.speed;
+
+  //Update hitbox and corners
+  player.bottom_left.y = player.y + player.height * player.scale_y;
+  player.bottom_right.y = player.y + player.height * player.scale_y;
+  player.bottom_left.x = player.x;
+  player.bottom_right.x = player.x + (player.width * player.scale_x);
+
+  player.hitbox.bottom_right = player.bottom_right;
+  player.hitbox.top_left.x = player.x;
+  player.hitbox.top_left.y = player.y;
+
+  if (player.x < -(player.width * player.scale_x)) //Wrap player if he goes off the left side
+    player.x = WIDTH;
+
+  if (player.x > WIDTH) // Wrap player if he goes off the right side
+    player.x = -(player.width * player.scale_x);
+
+  if (PlayerCollidePlatforms(game) != -1) //Check for a collision
+  {
+    player.state = player.WALKING; //Change player state to walking
+    player.y_velocity = 0; //Kill the downward velocity
+    game.allow_double_jump = false;
+    game.has_double_jumped = false;
+    player.y = game.platforms.y[PlayerCollidePlatforms(game)] - (player.height * player.scale_y); //Make sure the player hasn't sunk into the platform
+  }
+  else
+  {
+    if (player.state != player.JUMPING)
+    {
+      player.state = player.FALLING; //If we're not jumping and we aren't touching the ground then we must be falling
+    }
+
+    if ((JustPressed(game, UP) || JustPressed(game, X)) && game.stars > 0 && game.allow_double_jump && !game.has_double_jumped)
+    {
+      player.state = player.JUMPING;
+      player.y_velocity = -player.jump_power;
+      --game.stars;
+      game.allow_double_jump = false;
+      game.has_double_jumped = true;
+      PushEvent(game, EVENT_SOUND, SOUND_DOUBLE_JUMP);
+    }
+  }
+
+  if (player.invulnerable > 0)
+    --player.invulnerable;
+
+  PlayerCollidePickups(game);
+  PlayerCollideEnemies(game);
+}
+
+void AnimatePlayer(Game &game)
+{
+  Player &player = game.player;
+
+  if (player.frame_count >= player.delay) //If the delay has passed
+  {
+    player.frame_count = 0; //Set counter to zero
+    ++player.current_frame; //Increment the current frame
+
+    if (player.current_frame > player.frames[player.current_animation] - 1) //if we've gone past the last frame
+      player.current_frame = 0; //Go back to the first frame
+  }
+
+  ++player.frame_count; //Increment delay counter
+}
+
+void ChangePlayerAnimation(Game &game, int animation, bool hard)
+{
+  Player &player = game.player;
+
+  if (hard || player.current_animation != animation)
+  {
+    player.frame_count = 0;
+    player.current_frame = 0;
+    player.current_animation = animation;
+  }
+}
+
+void SpawnPlatform(Game &game, int x, int y, int width, int height, bool roll_pickup)
+{
+  TRACE_SCOPE("SpawnPlatform");
+
+  if (game.num_platforms == max_platforms)
+    return;
+
+  //Platforms always go on top, the ring stays sorted as long as each one is spawned higher than the last
+  Platforms &platforms = game.platforms;
+  int i = PlatformSlot(game, game.num_platforms);
+
+  platforms.x[i] = x;
+  platforms.y[i] = y;
+  platforms.right[i] = x + width;
+  platforms.bottom[i] = y + height;
+
+  game.num_platforms++;
+
+  if (roll_pickup)
+  {
+    int rand_pickup = Rand(game, 100);
+
+    if (rand_pickup <= game.coin_chance)
+    {
+      SpawnPickup(game, (x + (width / 2)) - 18, y - 50, COIN);
+    }
+    else if (rand_pickup > game.coin_chance && rand_pickup <= game.coin_chance + game.star_chance)
+    {
+      SpawnPickup(game, (x + (width / 2)) - 18, y - 50, STAR);
+    }
+    else if (rand_pickup > game.coin_chance + game.star_chance && rand_pickup <= game.coin_chance + game.star_chance + game.enemy_chance)
+    {
+      //Spread them out along the platform, they patrol from one end to the other
+      int range = width - enemy_size;
+
+      for (int i = 0; i < game.enemy_spawns; ++i)
+        SpawnEnemy(game, x + (range * i) / game.enemy_spawns, y - enemy_size, x, x + range);
+    }
+  }
+}
+
+void UpdatePlatforms(Game &game)
+{
+  PROFILE_SCOPE(PROFILE_UPDATE_PLATFORMS);
+
+  //If a platform is 100 pixels below the screen we can consider it useless and remove it, the lowest ones always go first
+  while (game.num_platforms > 0 && game.platforms.y[game.first_platform] > (-game.cam.y + game.cam.height + 100))
+    RemovePlatform(game);
+
+  //Fill the free space with new platforms above the highest one
+  while (game.num_platforms < max_platforms)
+  {
+    game.next_width = game.platform_widths[Rand(game, 11)];
+    game.next_width -= Rand(game, 50);
+
+    game.platform_spawn.y -= game.platform_increment * game.dificulty;
+    game.platform_spawn.x = ((WIDTH / 5) * Rand(game, 5)) - (game.next_width / 2) + 50;
+
+    SpawnPlatform(game, game.platform_spawn.x, game.platform_spawn.y, game.next_width, 32, true);
+  }
+}
+
+void RemovePlatform(Game &game)
+{
+  if (game.num_platforms == 0)
+    return;
+
+  TRACE_SCOPE("RemovePlatform");
+
+  game.first_platform = PlatformSlot(game, 1);
+  --game.num_platforms;
+}
+
+int PlatformSlot(const Game &game, int n)
+{
+  return (game.first_platform + n) % max_platforms;
+}
+
+int FindPlatform(const Game &game, int y)
+{
+  //Binary search, the tops get smaller going up the ring
+  int low = 0;
+  int high = game.num_platforms;
+
+  while (low < high)
+  {
+    int middle = (low + high) / 2;
+
+    if (game.platforms.y[PlatformSlot(game, middle)] <= y)
+      high = middle;
+    else
+      low = middle + 1;
+  }
+
+  return low;
+}
+
+int PlayerCollidePlatforms(const Game &game)
+{
+  const Player &player = game.player;
+  const Platforms &platforms = game.platforms;
+
+  if (player.state == player.JUMPING || game.num_platforms == 0)
+    return -1;
+
+  int feet = player.bottom_left.y;
+
+  //Only platforms with their top at or above the player's feet can be under them. Every platform is the same height
+  //so the bottoms are in order too, and the ones still reaching down to the feet come straight after
+  int first = FindPlatform(game, feet);
+  int last = first;
+
+  while (last < game.num_platforms && platforms.bottom[PlatformSlot(game, last)] >= feet)
+    ++last;
+
+  //Standing on an edge counts for platforms, so grow the feet a pixel each way. Platforms are always wider
+  //than the player, so the feet overlapping one is the same as either corner being on it
+  Rect box;
+  box.top_left.x = player.bottom_left.x - 1;
+  box.top_left.y = feet - 1;
+  box.bottom_right.x = player.bottom_right.x + 1;
+  box.bottom_right.y = feet + 1;
+
+  unsigned int hits[(max_platforms + 31) / 32];
+
+  //The ones to test are a run of the ring, in two pieces if it wraps round the end of the arrays
+  for (int n = first; n < last;)
+  {
+    int slot = PlatformSlot(game, n);
+    int run = last - n < max_platforms - slot ? last - n : max_platforms - slot;
+
+    if (OverlapBoxes(platforms.x + slot, platforms.y + slot, platforms.right + slot, platforms.bottom + slot, run, box, hits) > 0)
+      return slot + NextHit(hits, run, 0);
+
+    n += run;
+  }
+
+  return -1;
+}
+
+void SpawnPickup(Game &game, int x, int y, int type)
+{
+  if (game.num_pickups == max_pickups)
+    return;
+
+  Pickups &pickups = game.pickups;
+  int i = game.num_pickups;
+
+  pickups.x[i] = x;
+  pickups.y[i] = y;
+  pickups.right[i] = x + pickup_size;
+  pickups.bottom[i] = y + pickup_size;
+  pickups.type[i] = type;
+  pickups.frame_count[i] = 0;
+  pickups.current_frame[i] = 0;
+
+  ++game.num_pickups;
+}
+
+void UpdatePickups(Game &game)
+{
+  PROFILE_SCOPE(PROFILE_UPDATE_PICKUPS);
+
+  int bottom = -game.cam.y + game.cam.height + 100;
+
+  //Go backwards so the pickup swapped in to a removed one's place has already been checked
+  for (int i = game.num_pickups - 1; i >= 0; --i)
+  {
+    if (game.pickups.y[i] > bottom)
+      RemovePickup(game, i);
+  }
+}
+
+void AnimatePickups(Game &game)
+{
+  Pickups &pickups = game.pickups;
+
+  for (int i = 0; i < game.num_pickups; ++i)
+  {
+    if (pickups.frame_count[i] >= pickup_delay) //If the delay has passed
+    {
+      pickups.frame_count[i] = 0; //Set counter to zero
+      ++pickups.current_frame[i]; //Increment the current frame
+
+      if (pickups.current_frame[i] > pickup_frames - 1) //if we've gone past the last frame
+        pickups.current_frame[i] = 0; //Go back to the first frame
+    }
+
+    ++pickups.frame_count[i]; //Increment delay counter
+  }
+}
+
+void PlayerCollidePickups(Game &game)
+{
+  const Player &player = game.player;
+  const Pickups &pickups = game.pickups;
+
+  unsigned int hits[(max_pickups + 31) / 32];
+
+  //Only one a tick, the rest get picked up next tick if we're still touching them
+  if (OverlapBoxes(pickups.x, pickups.y, pickups.right, pickups.bottom, game.num_pickups, player.hitbox, hits) > 0)
+    CollectPickup(game, NextHit(hits, game.num_pickups, 0));
+}
+
+void CollectPickup(Game &game, int id)
+{
+  switch(game.pickups.type[id])
+  {
+  case COIN:
+    game.score += 10;
+    game.coins++;
+    PushEvent(game, EVENT_SOUND, SOUND_COIN);
+    break;
+  case STAR:
+    game.stars++;
+    PushEvent(game, EVENT_SOUND, SOUND_STAR);
+    break;
+  }
+
+  RemovePickup(game, id);
+}
+
+void RemovePickup(Game &game, int id)
+{
+  Pickups &pickups = game.pickups;
+  int last = --game.num_pickups;
+
+  pickups.x[id] = pickups.x[last];
+  pickups.y[id] = pickups.y[last];
+  pickups.right[id] = pickups.right[last];
+  pickups.bottom[id] = pickups.bottom[last];
+  pickups.type[id] = pickups.type[last];
+  pickups.frame_count[id] = pickups.frame_count[last];
+  pickups.current_frame[id] = pickups.current_frame[last];
+}
+
+void SpawnEnemy(Game &game, int x, int y, int left, int right)
+{
+  if (game.num_enemies == max_enemies)
+    return;
+
+  Enemies &enemies = game.enemies;
+  int i = game.num_enemies;
+
+  enemies.x[i] = x;
+  enemies.y[i] = y;
+  enemies.right[i] = x + enemy_size;
+  enemies.bottom[i] = y + enemy_size;
+  enemies.speed[i] = x < (left + right) / 2 ? enemy_speed : -enemy_speed; //Start off walking towards the far end
+  enemies.walk_left[i] = left;
+  enemies.walk_right[i] = right;
+  enemies.frame_count[i] = 0;
+  enemies.current_frame[i] = 0;
+  enemies.dying[i] = 0;
+
+  ++game.num_enemies;
+}
+
+void UpdateEnemies(Game &game)
+{
+  PROFILE_SCOPE(PROFILE_UPDATE_ENEMIES);
+
+  Enemies &enemies = game.enemies;
+
+  //Walk, turning round at the ends of the platform. Squashed ones stay where they are
+  for (int i = 0; i < game.num_enemies; ++i)
+  {
+    if (enemies.dying[i] == 0)
+      enemies.x[i] += enemies.speed[i];
+
+    enemies.right[i] = enemies.x[i] + enemy_size;
+
+    if (enemies.x[i] <= enemies.walk_left[i])
+      enemies.speed[i] = enemy_speed;
+    else if (enemies.x[i] >= enemies.walk_right[i])
+      enemies.speed[i] = -enemy_speed;
+  }
+
+  int bottom = -game.cam.y + game.cam.height + 100;
+
+  //Go backwards so the enemy swapped in to a removed one's place has already been checked
+  for (int i = game.num_enemies - 1; i >= 0; --i)
+  {
+    if (enemies.dying[i] > 0 && --enemies.dying[i] == 0)
+      RemoveEnemy(game, i);
+    else if (enemies.y[i] > bottom)
+      RemoveEnemy(game, i);
+  }
+}
+
+void AnimateEnemies(Game &game)
+{
+  Enemies &enemies = game.enemies;
+
+  for (int i = 0; i < game.num_enemies; ++i)
+  {
+    if (enemies.frame_count[i] >= enemy_delay) //If the delay has passed
+    {
+      enemies.frame_count[i] = 0; //Set counter to zero
+      ++enemies.current_frame[i]; //Increment the current frame
+
+      if (enemies.current_frame[i] > enemy_frames - 1) //if we've gone past the last frame
+        enemies.current_frame[i] = 0; //Go back to the first frame
+    }
+
+    ++enemies.frame_count[i]; //Increment delay counter
+  }
+}
+
+void PlayerCollideEnemies(Game &game)
+{
+  Player &player = game.player;
+  Enemies &enemies = game.enemies;
+
+  //Landing on an enemy squashes it, that's when the player's feet were above it last tick and they're coming down
+  bool falling = player.y_velocity > 0;
+  int last_feet = player.hitbox.bottom_right.y - (int)player.y_velocity;
+
+  bool stomped = false;
+  bool hurt = false;
+
+  unsigned int hits[(max_enemies + 31) / 32];
+
+  if (OverlapBoxes(enemies.x, enemies.y, enemies.right, enemies.bottom, game.num_enemies, player.hitbox, hits) == 0)
+    return;
+
+  for (int i = NextHit(hits, game.num_enemies, 0); i < game.num_enemies; i = NextHit(hits, game.num_enemies, i + 1))
+  {
+    if (enemies.dying[i] == 0)
+    {
+      if (falling && last_feet <= enemies.y[i])
+      {
+        enemies.dying[i] = enemy_die_time;
+        game.score += 20;
+        stomped = true;
+      }
+      else
+      {
+        hurt = true;
+      }
+    }
+  }
+
+  //Bounce off whatever we squashed or got hurt by, but walk straight through them while flashing
+  if (stomped)
+  {
+    player.state = player.JUMPING;
+    player.y_velocity = -player.jump_power / 2;
+    PushEvent(game, EVENT_SOUND, SOUND_JUMP);
+  }
+  else if (hurt && player.invulnerable == 0)
+  {
+    --player.health;
+    player.invulnerable = invulnerable_time;
+    player.state = player.JUMPING;
+    player.y_velocity = -player.jump_power / 2;
+  }
+}
+
+void RemoveEnemy(Game &game, int id)
+{
+  Enemies &enemies = game.enemies;
+  int last = --game.num_enemies;
+
+  enemies.x[id] = enemies.x[last];
+  enemies.y[id] = enemies.y[last];
+  enemies.right[id] = enemies.right[last];
+  enemies.bottom[id] = enemies.bottom[last];
+  enemies.speed[id] = enemies.speed[last];
+  enemies.walk_left[id] = enemies.walk_left[last];
+  enemies.walk_right[id] = enemies.walk_right[last];
+  enemies.frame_count[id] = enemies.frame_count[last];
+  enemies.current_frame[id] = enemies.current_frame[last];
+  enemies.dying[id] = enemies.dying[last];
+}
+
+void PushEvent(Game &game, int type, int id)
+{
+  if (game.num_events < max_events)
+  {
+    game.events[game.num_events].type = type;
+    game.events[game.num_events].id = id;
+    ++game.num_events;
+  }
+}
+
+void PlaySong(Game &game)
+{
+  if (game.song_state != SONG_PLAYING)
+  {
+    PushEvent(game, EVENT_SONG_PLAY, 0);
+    game.song_state = SONG_PLAYING;
+  }
+}
+
+void PauseSong(Game &game)
+{
+  if (game.song_state == SONG_PLAYING)
+  {
+    PushEvent(game, EVENT_SONG_PAUSE, 0);
+    game.song_state = SONG_PAUSED;
+  }
+}
+
+void StopSong(Game &game)
+{
+  if (game.song_state != SONG_STOPPED)
+  {
+    PushEvent(game, EVENT_SONG_STOP, 0);
+    game.song_state = SONG_STOPPED;
+  }
+}
+
+void SeedRand(Game &game, unsigned int seed)
+{
+  game.seed = seed;
+
+  //Scramble the seed so that close seeds don't start close together, xorshift can't start from zero either
+  seed ^= seed >> 16;
+  seed *= 0x7feb352d;
+  seed ^= seed >> 15;
+  seed *= 0x846ca68b;
+  seed ^= seed >> 16;
+
+  game.rand_state = seed ? seed : 0x9e3779b9;
+}
+
+int Rand(Game &game, int limit)
+{
+  //xorshift32, small and quick and the same on every platform unlike rand()
+  unsigned int x = game.rand_state;
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  game.rand_state = x;
+
+  return (int)(x % (unsigned int)limit);
+}
+
+void NewGame(Game &game)
+{
+  game.scrolling = false;
+  game.game_over = false;
+
+  game.game_over_fade = 0;
+  game.game_over_fade_2 = 0;
+
+  game.submit_score = false;
+  game.name_entered = false;
+
+  game.submit_selection = 0;
+  game.score_name[0] = 0;
+  game.score_name[1] = 0;
+  game.score_name[2] = 0;
+
+  game.paused = false;
+
+  game.highest = 0;
+  game.score = 0;
+  game.coins = 0;
+  game.dificulty = 1;
+
+  game.coin_chance = 33;
+  game.star_chance = 5;
+  game.enemy_chance = 10;
+
+  game.play_death = true;
+
+
+  InitCamera(game);
+  InitPlayer(game);
+
+  //Remove all platforms
+  while (game.num_platforms > 0)
+    RemovePlatform(game);
+
+  game.first_platform = 0;
+
+  //Remove all pickups
+  while (game.num_pickups > 0)
+    RemovePickup(game, game.num_pickups - 1);
+
+  //Remove all enemies
+  while (game.num_enemies > 0)
+    RemoveEnemy(game, game.num_enemies - 1);
+
+  //Spawn the starting platforms
+  SpawnPlatform(game, 0, HEIGHT - 25, WIDTH, 32, false);
+  SpawnPlatform(game, 0, HEIGHT - 175, 100, 32, false);
+  SpawnPlatform(game, 125, HEIGHT - 250, 100, 32, false);
+  SpawnPlatform(game, 250, HEIGHT - 325, 100, 32, false);
+
+  game.platform_spawn.y = HEIGHT - 325;
+
+  game.new_game = false;
+}
@@ -0,0 +1,303 @@
+//The game simulation, everything that changes the state of the game lives in here.
+//Nothing in this file touches allegro so it can be stepped headless as fast as the cpu allows,
+//the windowed game and the tools in tools/ all drive it through StepGame.
+
+#ifndef SIMULATION_H
+#define SIMULATION_H
+
+#include "objects.h"
+
+//The FPS of the game, the simulation always advances 1/FPS of a second per step
+const int FPS = 60;
+
+//Width and height of the window
+const int WIDTH = 400;
+const int HEIGHT = 600;
+
+//Maximum number of platforms at any one time. Collision only looks at the platforms near the player
+//so this can go up in to the thousands without slowing the step down
+const int max_platforms = 12;
+
+//Maximum number of pickups at any one time
+const int max_pickups = 12;
+
+//Width and height of a pickup
+const int pickup_size = 32;
+
+//Number of frames in a pickup animation and how many ticks each is shown for
+const int pickup_frames = 4;
+const int pickup_delay = 6;
+
+//Maximum number of enemies at any one time, normally there's only ever a few but stress tests put lots on each platform
+const int max_enemies = 256;
+
+//Width and height of an enemy, and how many pixels it walks each tick
+const int enemy_size = 32;
+const int enemy_speed = 1;
+
+//Number of frames in the enemy walk animation, how many ticks each is shown for, and how long a squashed enemy stays
+const int enemy_frames = 2;
+const int enemy_delay = 10;
+const int enemy_die_time = 30;
+
+//How long the player flashes for after being hurt, they can't be hurt again until it's over
+const int invulnerable_time = 90;
+
+//Maximum number of events a single step can report
+const int max_events = 64;
+
+//Number of characters available for saving highscore names
+const int num_chars = 28;
+
+//Array of characters for saving highscore names
+const char name_chars[num_chars] = "ABCDEFGHIJKLMNOPQRSTUVWXYZ.";
+
+//Each key is one bit in the input mask passed to StepGame, 1 << UP means up is down
+enum KEYS{UP, DOWN, LEFT, RIGHT, X, Z, R, P, S, ENTER, ESCAPE};
+const int num_keys = 11;
+
+//Keeps track of the state, changing current_state will switch the state.
+enum STATES{GAME, MENU, INSTRUCTIONS, LEADERBOARD};
+
+//Sound ids reported with EVENT_SOUND, these match the order of sounds[] in assets.h
+enum SOUNDS{SOUND_COIN, SOUND_STAR, SOUND_DIE, SOUND_JUMP, SOUND_DOUBLE_JUMP, SOUND_PAUSE};
+const int num_sounds = 6;
+
+//Where the theme tune is at
+enum SONG_STATES{SONG_STOPPED, SONG_PLAYING, SONG_PAUSED};
+
+//Side effects of a step, the simulation can't play sounds so it reports them instead
+enum EVENTS
+{
+  EVENT_SOUND, //Play sound id once
+  EVENT_SONG_PLAY, //Start the theme tune, from where it was paused if it was
+  EVENT_SONG_PAUSE, //Pause the theme tune where it is
+  EVENT_SONG_STOP, //Stop the theme tune and go back to the start
+  EVENT_SUBMIT_SCORE //Save id as a high score under the name in score_name
+};
+
+struct GameEvent
+{
+  int type;
+  int id;
+};
+
+//Every platform, an array per field so a pass over them only pulls in the fields it uses.
+//They're kept in a ring sorted by y, see first_platform in Game. Boxes are kept as their edges for OverlapBoxes
+struct Platforms
+{
+  int x[max_platforms];
+  int y[max_platforms];
+  int right[max_platforms];
+  int bottom[max_platforms];
+};
+
+//Every pickup, an array per field. The live ones are packed at the front, removing one moves the last in to its place
+struct Pickups
+{
+  int x[max_pickups];
+  int y[max_pickups];
+  int right[max_pickups];
+  int bottom[max_pickups];
+  int type[max_pickups];
+  int frame_count[max_pickups];
+  int current_frame[max_pickups];
+};
+
+//Every enemy, an array per field. The live ones are packed at the front, removing one moves the last in to its place
+struct Enemies
+{
+  int x[max_enemies];
+  int y[max_enemies];
+  int right[max_enemies];
+  int bottom[max_enemies];
+  int speed[max_enemies]; //Which way it's walking, enemy_speed or -enemy_speed
+  int walk_left[max_enemies]; //How far it can walk each way before turning round, the ends of its platform
+  int walk_right[max_enemies];
+  int frame_count[max_enemies];
+  int current_frame[max_enemies];
+  int dying[max_enemies]; //Ticks left of the death animation, 0 while it's walking
+};
+
+//All of the state for one game, copy it around freely, there are no pointers in here. Snapshots depend on that, see snapshot.h
+//Snapshots are these bytes as they are, so bump snapshot_version in snapshot.h when adding, removing or moving a field
+struct Game
+{
+  //Input mask for this step and the last one, for determining JustPressed
+  unsigned int keys;
+  unsigned int old_keys;
+
+  int current_state;
+
+  //The seed this game was started with and the current state of its random number generator.
+  //Everything random comes from here so the same seed and input always plays out the same
+  unsigned int seed;
+  unsigned int rand_state;
+
+  //Set to true when the player picks exit from the menu
+  bool done;
+
+  //Keeps track of if the game is paused or not
+  bool paused;
+
+  //Set this to true to reset everything for a new game
+  bool new_game;
+
+  //When this is true display game over screen
+  bool game_over;
+
+  //Set this to true to start the automatic scrolling upwards
+  bool scrolling;
+
+  //The current speed of the upward scroll
+  float scroll_speed;
+
+  //The maximum possible scroll speed
+  float max_scroll_speed;
+
+  //Keeps track of the highest point reached so far
+  int highest;
+
+  //Keeps track of the total score
+  int score;
+
+  int coins;
+
+  //A bit hacky, keeps track of where zero score should be
+  int zero;
+
+  //Keeps track of the dificulty, increase this to make the game wait longer before spawning a new platform
+  float dificulty;
+
+  //Max dificulty, make sure player can always make the jumps
+  float max_dificulty;
+
+  //The minimum amount of space between each platform
+  int platform_increment;
+
+  //Point for calculating the next platform location
+  Point platform_spawn;
+
+  //Array containing the possible widths for platforms
+  int platform_widths[11];
+
+  //Helper for calculating the next width
+  int next_width;
+
+  //Platforms are kept in the order they were spawned, which is from the bottom of the tower to the top.
+  //The lowest is at index first_platform and the rest follow it wrapping round the end of the arrays
+  int first_platform;
+
+  //Keeps track of the number of platforms currently alive
+  int num_platforms;
+
+  //int for fading in the game over screen
+  int game_over_fade;
+  int game_over_fade_2;
+
+  //Keeps track of the number of pickups currently alive, they're the first num_pickups in the arrays
+  int num_pickups;
+
+  //Probability of a pickup being spawned
+  int coin_chance;
+
+  int star_chance;
+
+  int enemy_chance;
+
+  //Keeps track of the number of enemies currently alive, they're the first num_enemies in the arrays
+  int num_enemies;
+
+  //Number of enemies put on a platform when it gets them, only ever more than 1 for stress tests
+  int enemy_spawns;
+
+  //True when the user chooses to submit highscore
+  bool submit_score;
+
+  //True after a name has been entered
+  bool name_entered;
+
+  //The current letter to change in the highscore name
+  int submit_selection;
+
+  //Character selection for name
+  int score_name[3];
+
+  //Number of stars collected
+  int stars;
+
+  bool allow_double_jump;
+
+  bool has_double_jumped;
+
+  int menu_selection;
+
+  bool play_song;
+  bool play_death;
+
+  //What the theme tune should be doing, so we only report changes
+  int song_state;
+
+  //Objects
+  Player player; //The player object
+  Platforms platforms; //Ring buffer containing all of the platforms, sorted by y
+  Pickups pickups; //All the pickups, packed at the front
+  Enemies enemies; //All the enemies, packed at the front
+  Camera cam; //The camera object, the simulation only cares about where it is
+
+  //Events reported by the last step
+  GameEvent events[max_events];
+  int num_events;
+};
+
+void InitGame(Game &game, unsigned int seed); //Sets up a fresh game sitting on the menu, call once before the first step
+int StepGame(Game &game, unsigned int keys); //Advances the game by one tick with the given input mask, returns the number of events in game.events
+
+//True when stepping again with the same input as the last step would change nothing, on the menu, instructions, leaderboard, paused
+//or a game over screen that's finished fading. Those steps can be skipped until the input changes
+bool GameIdle(const Game &game);
+
+bool KeyDown(const Game &game, int key); //Returns true if key is held down this step
+bool JustPressed(const Game &game, int key); //Returns true if key has just been pressed this step
+
+void InitCamera(Game &game);
+
+void UpdateDifficulty(Game &game); //Raises the platform spacing and scroll speed to match the highest point reached
+
+void InitPlayer(Game &game); //Player constructor, initializes all the starting variables etc.
+void UpdatePlayer(Game &game); //Updates all player logic
+void AnimatePlayer(Game &game); //Advances the player animation by one tick
+void ChangePlayerAnimation(Game &game, int animation, bool hard); //Changes the current animation, set hard to true to restart the animation
+
+void SpawnPlatform(Game &game, int x, int y, int width, int height, bool roll_pickup); //Spawns a platform of width*height at x,y above all the others, set roll_pickup to maybe put a pickup on it
+void UpdatePlatforms(Game &game);
+void RemovePlatform(Game &game); //"kills" the lowest platform
+int PlatformSlot(const Game &game, int n); //Returns the index in the arrays of the nth platform up from the bottom
+int FindPlatform(const Game &game, int y); //Returns n of the lowest platform with its top at or above y, or num_platforms if there isn't one
+int PlayerCollidePlatforms(const Game &game); //Returns the index of the platform being collided with or -1 if no collision.
+
+void SpawnPickup(Game &game, int x, int y, int type); //Spawns a pickup of type at x,y
+void UpdatePickups(Game &game); //Updates the pickups
+void AnimatePickups(Game &game); //Advances the pickup animations by one tick
+void PlayerCollidePickups(Game &game); //Checks for collisions on all the pickups currently in play, calling CollectPickup if necessary
+void CollectPickup(Game &game, int id); //To be called when a pickup is collected, takes actions depending on pickup
+void RemovePickup(Game &game, int id); //Removes the pickup from play, the last pickup takes its id
+
+void SpawnEnemy(Game &game, int x, int y, int left, int right); //Spawns an enemy at x,y that walks between left and right
+void UpdateEnemies(Game &game); //Walks the enemies and removes the ones that have finished dying or gone off the screen
+void AnimateEnemies(Game &game); //Advances the enemy walk animations by one tick
+void PlayerCollideEnemies(Game &game); //Squashes enemies landed on and hurts the player for the rest they touch
+void RemoveEnemy(Game &game, int id); //Removes the enemy from play, the last enemy takes its id
+
+
+void PushEvent(Game &game, int type, int id); //Reports a side effect of this step
+void PlaySong(Game &game); //Reports the theme tune starting or resuming if it isn't already playing
+void PauseSong(Game &game); //Reports the theme tune pausing if it is playing
+void StopSong(Game &game); //Reports the theme tune stopping if it isn't already stopped
+
+void SeedRand(Game &game, unsigned int seed); //Restarts the random number generator from seed
+int Rand(Game &game, int limit); //Returns a random number from 0 to limit - 1
+
+void NewGame(Game &game); //Re-initializes everything for a new game
+
+#endif
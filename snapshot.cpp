@@ -0,0 +1,101 @@
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "files.h"
+#include "snapshot.h"
+#include "trace.h"
+
+using namespace std;
+
+//True if everything the simulation uses as a count or an index is in range. The check only proves the file is what
+//was written, not that what was written makes sense to this build, and a count past the end of its arrays would
+//have the next step reading and writing off the end of them
+static bool GameFits(const Game &game)
+{
+  const Player &player = game.player;
+
+  if (game.num_platforms < 0 || game.num_platforms > max_platforms ||
+      game.first_platform < 0 || game.first_platform >= max_platforms ||
+      game.num_pickups < 0 || game.num_pickups > max_pickups ||
+      game.num_enemies < 0 || game.num_enemies > max_enemies ||
+      game.num_events < 0 || game.num_events > max_events)
+    return false;
+
+  //Indexes in to the menu, the name being entered and the player's animations
+  if (game.current_state < GAME || game.current_state > LEADERBOARD ||
+      game.menu_selection < 0 || game.menu_selection > 3 ||
+      game.submit_selection < 0 || game.submit_selection > 2 ||
+      game.song_state < SONG_STOPPED || game.song_state > SONG_PAUSED ||
+      player.current_animation < player.STAND || player.current_animation > player.JUMP)
+    return false;
+
+  for (int i = 0; i < 3; ++i)
+  {
+    if (game.score_name[i] < 0 || game.score_name[i] > num_chars - 2)
+      return false;
+  }
+
+  return true;
+}
+
+void TakeSnapshot(const Game &game, Snapshot &snapshot)
+{
+  memcpy(snapshot.magic, "TCSS", 4);
+  snapshot.version = snapshot_version;
+  snapshot.size = sizeof(Game);
+  snapshot.check = 0;
+  memcpy(&snapshot.game, &game, sizeof(Game));
+}
+
+void RestoreSnapshot(Game &game, const Snapshot &snapshot)
+{
+  memcpy(&game, &snapshot.game, sizeof(Game));
+}
+
+bool WriteSnapshot(const char *path, Snapshot &snapshot)
+{
+  TRACE_SCOPE("WriteSnapshot");
+
+  snapshot.check = Checksum(&snapshot.game, sizeof(Game));
+
+  //Only guards against the game crashing, not the machine, so there's no waiting for it to reach the disk
+  string temp_path = string(path) + ".new";
+  FILE *file = fopen(temp_path.c_str(), "wb");
+
+  if (!file)
+    return false;
+
+  bool ok = fwrite(&snapshot, sizeof(Snapshot), 1, file) == 1;
+  ok = fclose(file) == 0 && ok;
+
+  if (!ok || !RenameOver(temp_path.c_str(), path, false))
+  {
+    remove(temp_path.c_str());
+    return false;
+  }
+
+  return true;
+}
+
+bool ReadSnapshot(const char *path, Snapshot &snapshot)
+{
+  FILE *file = fopen(path, "rb");
+
+  if (!file)
+    return false;
+
+  //Read in to a spare so a bad file doesn't leave half of itself behind
+  vector<Snapshot> read(1);
+  bool ok = fread(&read[0], sizeof(Snapshot), 1, file) == 1 && fgetc(file) == EOF;
+
+  fclose(file);
+
+  if (!ok || memcmp(read[0].magic, "TCSS", 4) != 0 || read[0].version != (unsigned int)snapshot_version ||
+      read[0].size != sizeof(Game) || read[0].check != Checksum(&read[0].game, sizeof(Game)) || !GameFits(read[0].game))
+    return false;
+
+  snapshot = read[0];
+  return true;
+}
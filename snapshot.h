@@ -0,0 +1,52 @@
+//Snapshots of the whole game, for quick saves, the crash recovery autosave and skipping ahead in tests.
+//Everything the simulation knows lives in Game, which holds no pointers, only ids like a pickup's type or the
+//player's animation that the front end turns back in to bitmaps and sounds. So a snapshot is a copy of Game with a
+//header on the front, taking or restoring one is a single memcpy and cheap enough to do every tick.
+//
+//The bytes are Game as this build lays it out, so a snapshot only loads in to the build that took it and the header
+//is there to catch the ones that don't fit. To keep a game across versions record a replay instead, see replay.h.
+//
+//File format, the Snapshot struct as it is in memory:
+//  "TCSS"          magic
+//  u32 version     snapshot_version
+//  u32 size        sizeof(Game)
+//  u32 check       FNV-1a over the game, only filled in when it's written out
+//  then the game
+
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <type_traits>
+
+#include "simulation.h"
+
+//Anything added to Game has to keep it copyable byte for byte, or snapshots would copy pointers in to nowhere
+static_assert(std::is_trivially_copyable<Game>::value, "Game must stay plain data for snapshots");
+
+const int snapshot_version = 1;
+
+//A snapshot is Game's bytes, so any change to Game has to bump snapshot_version or old snapshots would load in to
+//the wrong fields. The size here is only to make that hard to forget, it won't catch a change that keeps the size
+static_assert(sizeof(Game) == 11644, "Game has changed, bump snapshot_version and then update the size here");
+
+struct Snapshot
+{
+  char magic[4];
+  unsigned int version;
+  unsigned int size;
+  unsigned int check;
+  Game game;
+};
+
+void TakeSnapshot(const Game &game, Snapshot &snapshot);
+void RestoreSnapshot(Game &game, const Snapshot &snapshot); //Puts the game back how it was, events and all
+
+//Writes snapshot next to path and renames it over the top, so a crash part way through leaves the old one whole.
+//Returns false if it couldn't
+bool WriteSnapshot(const char *path, Snapshot &snapshot);
+
+//Reads a snapshot written by WriteSnapshot. Returns false and leaves snapshot alone if the file is missing, is from
+//a different build, fails its check or has counts or indexes the simulation can't use
+bool ReadSnapshot(const char *path, Snapshot &snapshot);
+
+#endif
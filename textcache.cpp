@@ -0,0 +1,81 @@
+#include <cstdarg>
+#include <cstdio>
+#include <cstring>
+
+#include <Allegro5\allegro.h>
+#include <Allegro5\allegro_font.h>
+
+#include "textcache.h"
+
+//Spare pixels past the advance width, some glyphs hang over the end of it
+const int text_overhang = 4;
+
+void SetCachedText(CachedText &cache, const ALLEGRO_FONT *font, const char *text)
+{
+  if (cache.font == font && strncmp(cache.text, text, max_cached_text - 1) == 0)
+    return;
+
+  cache.font = font;
+  strncpy(cache.text, text, max_cached_text - 1);
+  cache.text[max_cached_text - 1] = '\0';
+
+  cache.width = al_get_text_width(font, cache.text);
+  cache.height = al_get_font_line_height(font);
+
+  int width = cache.width + text_overhang;
+
+  if (cache.bitmap && (al_get_bitmap_width(cache.bitmap) < width || al_get_bitmap_height(cache.bitmap) < cache.height))
+  {
+    al_destroy_bitmap(cache.bitmap);
+    cache.bitmap = NULL;
+  }
+
+  //Leave room to grow so a score going up a digit doesn't need a new one
+  if (!cache.bitmap)
+    cache.bitmap = al_create_bitmap(width * 3 / 2, cache.height);
+
+  if (!cache.bitmap)
+    return;
+
+  ALLEGRO_BITMAP *target = al_get_target_bitmap();
+
+  al_set_target_bitmap(cache.bitmap);
+  al_clear_to_color(al_map_rgba(0,0,0,0));
+  al_draw_text(font, al_map_rgb(255,255,255), 0, 0, 0, cache.text);
+  al_set_target_bitmap(target);
+}
+
+void SetCachedTextf(CachedText &cache, const ALLEGRO_FONT *font, const char *format, ...)
+{
+  char text[max_cached_text];
+  va_list args;
+
+  va_start(args, format);
+  vsnprintf(text, sizeof(text), format, args);
+  va_end(args);
+
+  SetCachedText(cache, font, text);
+}
+
+void DrawCachedText(const CachedText &cache, ALLEGRO_COLOR color, float x, float y, int flags)
+{
+  if (!cache.bitmap)
+    return;
+
+  if (flags & ALLEGRO_ALIGN_CENTER)
+    x -= cache.width / 2;
+  else if (flags & ALLEGRO_ALIGN_RIGHT)
+    x -= cache.width;
+
+  al_draw_tinted_bitmap_region(cache.bitmap, color, 0, 0, cache.width + text_overhang, cache.height, (int)x, (int)y, 0);
+}
+
+void DestroyCachedText(CachedText &cache)
+{
+  if (cache.bitmap)
+    al_destroy_bitmap(cache.bitmap);
+
+  cache.bitmap = NULL;
+  cache.font = NULL;
+  cache.text[0] = '\0';
+}
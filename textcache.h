@@ -0,0 +1,34 @@
+//Text drawn from a bitmap it was rendered to once, instead of laying out every glyph from the font each frame.
+//The bitmap is only rendered again when the text or font changes, so a score is redrawn when it goes up and
+//a menu item never is. Text is rendered white and tinted when it's drawn, so changing colour is free.
+
+#ifndef TEXTCACHE_H
+#define TEXTCACHE_H
+
+#include <Allegro5\allegro.h>
+#include <Allegro5\allegro_font.h>
+
+//Longest string a cache holds, anything past this is cut off
+const int max_cached_text = 64;
+
+//Zeroed is empty and ready to use
+struct CachedText
+{
+  ALLEGRO_BITMAP *bitmap; //Can be wider than the text, it's only made again when the text outgrows it
+  const ALLEGRO_FONT *font;
+  int width; //Of the text, for alignment
+  int height;
+  char text[max_cached_text];
+};
+
+//Renders text in to the cache if it isn't already what's there. This changes the target bitmap and puts it back,
+//so don't call it while drawing is held
+void SetCachedText(CachedText &cache, const ALLEGRO_FONT *font, const char *text);
+void SetCachedTextf(CachedText &cache, const ALLEGRO_FONT *font, const char *format, ...);
+
+//Draws whatever was last set, flags are the ALLEGRO_ALIGN ones al_draw_text takes. Fine while drawing is held
+void DrawCachedText(const CachedText &cache, ALLEGRO_COLOR color, float x, float y, int flags);
+
+void DestroyCachedText(CachedText &cache);
+
+#endif
@@ -0,0 +1,354 @@
+//Tower analyzer, builds the towers the game would for lots of seeds on every core and checks every platform can be
+//jumped to from the one below it, see jumps.h. For tuning dificulty, max_dificulty, platform_increment,
+//platform_widths and scroll_speed without weeks of playing.
+//
+//Build: g++ -O2 -pthread -I.. analyzer.cpp ../simulation.cpp ../jumps.cpp ../profiler.cpp ../trace.cpp ../collision.cpp -o analyzer
+//Usage: analyzer [-towers n] [-seed n] [-height n] [-threads n] [-list]
+//
+//Seeds -seed to -seed + towers - 1 are each built up to -height pixels by UpdatePlatforms, with the dificulty
+//rising as if the player were climbing at the scroll threshold a quarter of the way down the screen.
+//The best score for a seed is what a perfect player could get: climbing until the first gap that can't be jumped,
+//or can only be double jumped with no star saved up, picking up every coin and star on the way.
+//-list prints each seed's best score and where it got stuck as well as the totals.
+
+#include <atomic>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include "../simulation.h"
+#include "../jumps.h"
+
+using namespace std;
+
+//Gaps are counted by the dificulty they were spawned at, in steps of a tenth from 1
+const int dificulty_bands = 20;
+
+//Seeds handed to a worker at a time
+const int seeds_per_batch = 256;
+
+const int histogram_bars = 10;
+
+struct TowerResult
+{
+  int score; //Best possible, see the top
+  int climbed; //Pixels climbed to the highest platform that can be reached
+  bool stuck; //There's a gap that can't be got past below height
+  int stars_used;
+};
+
+struct GapCounts
+{
+  long long gaps[dificulty_bands][JUMP_IMPOSSIBLE + 1];
+};
+
+//Set up by main before the workers start
+static const Jumps *jumps;
+static unsigned int first_seed;
+static long long num_towers;
+static int height;
+static vector<TowerResult> results;
+
+static atomic<long long> next_tower(0);
+
+static Rect PlatformBox(const Game &game, int slot)
+{
+  Rect box;
+  box.top_left.x = game.platforms.x[slot];
+  box.top_left.y = game.platforms.y[slot];
+  box.bottom_right.x = game.platforms.right[slot];
+  box.bottom_right.y = game.platforms.bottom[slot];
+  return box;
+}
+
+static void BuildTower(Game &game, unsigned int seed, GapCounts &counts, TowerResult &result)
+{
+  InitGame(game, seed);
+  game.current_state = GAME;
+  NewGame(game);
+
+  const Player &player = game.player;
+  int standing = player.height * player.scale_y;
+
+  Rect below;
+  bool have_below = false;
+  int seen = HEIGHT; //Top of the highest platform looked at so far, everything above it is new
+  int coins = 0;
+  int stars = 0;
+
+  result.climbed = 0;
+  result.stuck = false;
+  result.stars_used = 0;
+
+  while (game.highest < height)
+  {
+    int band = (int)((game.dificulty - 1) * 10);
+
+    if (band < 0)
+      band = 0;
+    else if (band >= dificulty_bands)
+      band = dificulty_bands - 1;
+
+    UpdatePlatforms(game);
+
+    //New platforms are the ones above seen, at the top of the ring
+    int n = game.num_platforms;
+
+    while (n > 0 && game.platforms.y[PlatformSlot(game, n - 1)] < seen)
+      --n;
+
+    for (; n < game.num_platforms; ++n)
+    {
+      Rect platform = PlatformBox(game, PlatformSlot(game, n));
+
+      if (have_below)
+      {
+        int needs = JumpNeeds(*jumps, below, platform);
+        ++counts.gaps[band][needs];
+
+        if (!result.stuck)
+        {
+          if (needs == JUMP_IMPOSSIBLE || (needs == JUMP_DOUBLE && stars == 0))
+          {
+            result.stuck = true;
+          }
+          else if (needs == JUMP_DOUBLE)
+          {
+            --stars;
+            ++result.stars_used;
+          }
+        }
+      }
+
+      if (!result.stuck)
+      {
+        //Anything rolled for this platform sits just above it, in reach of someone standing on it
+        for (int i = 0; i < game.num_pickups; ++i)
+        {
+          if (game.pickups.y[i] == platform.top_left.y - 50)
+          {
+            if (game.pickups.type[i] == COIN)
+              ++coins;
+            else if (game.pickups.type[i] == STAR)
+              ++stars;
+          }
+        }
+
+        result.climbed = game.zero - (platform.top_left.y - standing);
+      }
+
+      below = platform;
+      have_below = true;
+      seen = platform.top_left.y;
+    }
+
+    //Only needed for what was just spawned, and there's no UpdatePickups or UpdateEnemies here to clear them out
+    game.num_pickups = 0;
+    game.num_enemies = 0;
+
+    //Move up until the lowest platform drops off the bottom, making room for the next one
+    game.cam.y = -(game.platforms.y[game.first_platform] - game.cam.height - 100) + 1;
+    game.highest = game.zero - (HEIGHT / 4 - game.cam.y);
+
+    if (game.highest < 0)
+      game.highest = 0;
+
+    UpdateDifficulty(game);
+  }
+
+  //The same as the game's submitted score, see EVENT_SUBMIT_SCORE
+  result.score = result.climbed / 2 + coins * 10;
+}
+
+static void BuildTowers(GapCounts *counts)
+{
+  //A Game is too big to want on every thread's stack
+  vector<Game> game(1);
+
+  memset(counts, 0, sizeof(GapCounts));
+
+  for (;;)
+  {
+    long long start = next_tower.fetch_add(seeds_per_batch);
+
+    if (start >= num_towers)
+      break;
+
+    long long end = min(start + seeds_per_batch, num_towers);
+
+    for (long long i = start; i < end; ++i)
+      BuildTower(game[0], first_seed + (unsigned int)i, *counts, results[i]);
+  }
+}
+
+static double Percent(long long part, long long whole)
+{
+  return whole > 0 ? 100.0 * part / whole : 0;
+}
+
+int main(int argc, char **argv)
+{
+  num_towers = 100000;
+  first_seed = 1;
+  height = 30000;
+  int num_threads = thread::hardware_concurrency();
+  bool list = false;
+
+  for (int i = 1; i < argc; ++i)
+  {
+    if (strcmp(argv[i], "-towers") == 0 && i + 1 < argc)
+    {
+      num_towers = atoll(argv[++i]);
+    }
+    else if (strcmp(argv[i], "-seed") == 0 && i + 1 < argc)
+    {
+      first_seed = (unsigned int)strtoul(argv[++i], NULL, 10);
+    }
+    else if (strcmp(argv[i], "-height") == 0 && i + 1 < argc)
+    {
+      height = atoi(argv[++i]);
+    }
+    else if (strcmp(argv[i], "-threads") == 0 && i + 1 < argc)
+    {
+      num_threads = atoi(argv[++i]);
+    }
+    else if (strcmp(argv[i], "-list") == 0)
+    {
+      list = true;
+    }
+    else
+    {
+      fprintf(stderr, "Usage: %s [-towers n] [-seed n] [-height n] [-threads n] [-list]\n", argv[0]);
+      return 1;
+    }
+  }
+
+  if (num_towers < 1)
+    num_towers = 1;
+
+  if (num_threads < 1)
+    num_threads = 1;
+
+  //Every tower has the same player, measure its jumps once
+  Game game;
+  InitGame(game, first_seed);
+  InitPlayer(game);
+
+  vector<Jumps> measured(1);
+  MeasureJumps(game, measured[0]);
+  jumps = &measured[0];
+
+  results.resize(num_towers);
+
+  vector<GapCounts> counts(num_threads);
+  vector<thread> workers;
+
+  chrono::steady_clock::time_point start = chrono::steady_clock::now();
+
+  for (int i = 0; i < num_threads; ++i)
+    workers.push_back(thread(BuildTowers, &counts[i]));
+
+  for (int i = 0; i < num_threads; ++i)
+    workers[i].join();
+
+  double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+  GapCounts total;
+  memset(&total, 0, sizeof(total));
+
+  for (int i = 0; i < num_threads; ++i)
+  {
+    for (int band = 0; band < dificulty_bands; ++band)
+    {
+      for (int needs = 0; needs <= JUMP_IMPOSSIBLE; ++needs)
+        total.gaps[band][needs] += counts[i].gaps[band][needs];
+    }
+  }
+
+  if (list)
+  {
+    for (long long i = 0; i < num_towers; ++i)
+    {
+      const TowerResult &result = results[i];
+      printf("seed %u: score %i, climbed %i%s, stars used %i\n", first_seed + (unsigned int)i, result.score, result.climbed,
+        result.stuck ? " then stuck" : "", result.stars_used);
+    }
+  }
+
+  printf("towers: %lld up to %i pixels in %.3fs on %i threads (%.0f towers/s)\n", num_towers, height, seconds, num_threads, num_towers / seconds);
+
+  printf("gaps by dificulty:\n");
+  printf("  dificulty        gaps   standing    run up   double jump   impossible\n");
+
+  long long all_gaps = 0;
+  long long all_impossible = 0;
+  long long all_double = 0;
+
+  for (int band = 0; band < dificulty_bands; ++band)
+  {
+    const long long *gaps = total.gaps[band];
+    long long count = gaps[JUMP_STANDING] + gaps[JUMP_RUNNING] + gaps[JUMP_DOUBLE] + gaps[JUMP_IMPOSSIBLE];
+
+    if (count == 0)
+      continue;
+
+    printf("  %.1f-%.1f %12lld   %7.3f%%  %7.3f%%      %7.3f%%     %7.3f%%\n", 1 + band / 10.0, 1.1 + band / 10.0, count,
+      Percent(gaps[JUMP_STANDING], count), Percent(gaps[JUMP_RUNNING], count), Percent(gaps[JUMP_DOUBLE], count),
+      Percent(gaps[JUMP_IMPOSSIBLE], count));
+
+    all_gaps += count;
+    all_double += gaps[JUMP_DOUBLE];
+    all_impossible += gaps[JUMP_IMPOSSIBLE];
+  }
+
+  long long stuck = 0;
+  vector<int> scores(num_towers);
+
+  for (long long i = 0; i < num_towers; ++i)
+  {
+    stuck += results[i].stuck;
+    scores[i] = results[i].score;
+  }
+
+  sort(scores.begin(), scores.end());
+
+  double mean = 0;
+
+  for (long long i = 0; i < num_towers; ++i)
+    mean += (scores[i] - mean) / (i + 1);
+
+  printf("gaps: %lld, needing a star: %lld (%.3f%%), impossible: %lld (%.3f%%)\n", all_gaps, all_double, Percent(all_double, all_gaps),
+    all_impossible, Percent(all_impossible, all_gaps));
+  printf("towers that stop a perfect player: %lld (%.3f%%)\n", stuck, Percent(stuck, num_towers));
+  printf("best score per seed: min %i, p10 %i, median %i, p90 %i, max %i, mean %.1f\n", scores[0], scores[num_towers / 10],
+    scores[num_towers / 2], scores[num_towers * 9 / 10], scores[num_towers - 1], mean);
+
+  //Even steps from the lowest score to the highest
+  int low = scores[0];
+  int step = (scores[num_towers - 1] - low) / histogram_bars + 1;
+  long long bars[histogram_bars] = {0};
+  long long tallest = 0;
+
+  for (long long i = 0; i < num_towers; ++i)
+    ++bars[(scores[i] - low) / step];
+
+  for (int i = 0; i < histogram_bars; ++i)
+    tallest = max(tallest, bars[i]);
+
+  for (int i = 0; i < histogram_bars; ++i)
+  {
+    char bar[41];
+    int length = (int)(40 * bars[i] / tallest);
+
+    memset(bar, '#', length);
+    bar[length] = '\0';
+
+    printf("  %7i-%-7i %10lld %s\n", low + i * step, low + (i + 1) * step - 1, bars[i], bar);
+  }
+
+  return 0;
+}
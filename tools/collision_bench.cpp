@@ -0,0 +1,158 @@
+//Microbenchmark for the collision kernel, tests a player sized box against rows of entities the way the simulation does
+//and prints how many entity tests a second OverlapBoxes manages next to the one at a time version.
+//
+//Build: g++ -O2 -I.. collision_bench.cpp ../collision.cpp -o collision_bench
+//       add -mavx2 to try the AVX2 path, SSE2 is always there on x86-64
+//Usage: collision_bench [-seconds n]
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <vector>
+
+#include "../collision.h"
+
+using namespace std;
+
+typedef int (*OverlapFunction)(const int *, const int *, const int *, const int *, int, const Rect &, unsigned int *);
+
+//Entities scattered over a tall tower, about as dense as pickups get
+struct Entities
+{
+  vector<int> left;
+  vector<int> top;
+  vector<int> right;
+  vector<int> bottom;
+};
+
+void MakeEntities(Entities &entities, int count)
+{
+  entities.left.resize(count);
+  entities.top.resize(count);
+  entities.right.resize(count);
+  entities.bottom.resize(count);
+
+  for (int i = 0; i < count; ++i)
+  {
+    entities.left[i] = rand() % 400;
+    entities.top[i] = -i * 48 + rand() % 32;
+    entities.right[i] = entities.left[i] + 32;
+    entities.bottom[i] = entities.top[i] + 32;
+  }
+}
+
+//Box the player would have on run number run, moving up the tower so the answer keeps changing
+Rect PlayerBox(int run, int count)
+{
+  Rect box;
+  box.top_left.x = (run * 7) % 400;
+  box.top_left.y = -(run % (count + 1)) * 48;
+  box.bottom_right.x = box.top_left.x + 32;
+  box.bottom_right.y = box.top_left.y + 64;
+  return box;
+}
+
+//Returns true if the kernel sets exactly the same hits as the one at a time version for a spread of boxes
+bool Check(const Entities &entities)
+{
+  int count = (int)entities.left.size();
+  vector<unsigned int> expected(HitWords(count));
+  vector<unsigned int> hits(HitWords(count));
+
+  for (int run = 0; run < 1000; ++run)
+  {
+    Rect box = PlayerBox(run, count);
+
+    int expected_count = OverlapBoxesScalar(&entities.left[0], &entities.top[0], &entities.right[0], &entities.bottom[0], count, box, &expected[0]);
+    int hits_count = OverlapBoxes(&entities.left[0], &entities.top[0], &entities.right[0], &entities.bottom[0], count, box, &hits[0]);
+
+    if (hits_count != expected_count || hits != expected)
+      return false;
+  }
+
+  return true;
+}
+
+//Runs test against entities for about seconds and returns entity tests per second
+double Bench(OverlapFunction test, const Entities &entities, double seconds)
+{
+  int count = (int)entities.left.size();
+  vector<unsigned int> hits(HitWords(count));
+
+  long long tests = 0;
+  int hits_total = 0;
+  int run = 0;
+
+  chrono::steady_clock::time_point start = chrono::steady_clock::now();
+  double elapsed = 0;
+
+  while (elapsed < seconds)
+  {
+    //Check the clock every so often, reading it costs more than testing 12 entities
+    for (int j = 0; j < 1000; ++j, ++run)
+    {
+      Rect box = PlayerBox(run, count);
+
+      hits_total += test(&entities.left[0], &entities.top[0], &entities.right[0], &entities.bottom[0], count, box, &hits[0]);
+      tests += count;
+    }
+
+    elapsed = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+  }
+
+  //Keeps the compiler from deciding the hits were never needed
+  if (hits_total == -1)
+    printf("\n");
+
+  return tests / elapsed;
+}
+
+int main(int argc, char **argv)
+{
+  double seconds = 0.5;
+
+  for (int i = 1; i < argc; ++i)
+  {
+    if (strcmp(argv[i], "-seconds") == 0 && i + 1 < argc)
+    {
+      seconds = atof(argv[++i]);
+    }
+    else
+    {
+      fprintf(stderr, "Usage: %s [-seconds n]\n", argv[0]);
+      return 1;
+    }
+  }
+
+#if defined(__AVX2__)
+  printf("kernel: AVX2\n");
+#elif defined(__SSE2__) || defined(_M_X64)
+  printf("kernel: SSE2\n");
+#else
+  printf("kernel: scalar\n");
+#endif
+
+  const int sizes[] = {12, 1000, 100000};
+
+  printf("%10s %16s %16s %8s\n", "entities", "scalar tests/s", "kernel tests/s", "speedup");
+
+  for (int i = 0; i < 3; ++i)
+  {
+    Entities entities;
+    MakeEntities(entities, sizes[i]);
+
+    if (!Check(entities))
+    {
+      fprintf(stderr, "kernel and scalar disagree with %i entities\n", sizes[i]);
+      return 1;
+    }
+
+    double scalar = Bench(OverlapBoxesScalar, entities, seconds);
+    double kernel = Bench(OverlapBoxes, entities, seconds);
+
+    printf("%10i %16.3g %16.3g %7.2fx\n", sizes[i], scalar, kernel, kernel / scalar);
+  }
+
+  return 0;
+}
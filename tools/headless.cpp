@@ -0,0 +1,292 @@
+//Headless runner, steps the simulation as fast as it will go with no display, audio or timer.
+//Useful for soak tests and balancing runs on machines without a screen.
+//
+//Build: g++ -O2 -pthread -I.. headless.cpp ../simulation.cpp ../replay.cpp ../profiler.cpp ../trace.cpp ../collision.cpp ../jumps.cpp ../bot.cpp ../snapshot.cpp ../files.cpp -o headless
+//Usage: headless [-ticks n] [-seed n] [-record file] [-replay file] [-profile file] [-trace file] [-enemies n] [-bot]
+//                [-restore file] [-save file]
+//
+//With -replay the input comes from the file until it runs out and the run stops there,
+//running the same replay twice must always print the same final state.
+//-enemies puts n enemies on every platform that gets them instead of 1, for stress testing. It isn't saved
+//in replays so pass the same number again when playing one back.
+//-bot plays with the autopilot in bot.h instead of mashing keys, and prints how high each game got and how long its
+//steps took.
+//-restore carries on from a snapshot instead of starting on the menu, and -save writes one at the end, so a test can
+//skip straight to deep in to a game. A snapshot can't be recorded from or replayed in to, see snapshot.h.
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+
+#include "../simulation.h"
+#include "../replay.h"
+#include "../profiler.h"
+#include "../bot.h"
+#include "../snapshot.h"
+
+using namespace std;
+
+//Too big to want on the stack, see Jumps
+Bot bot;
+Snapshot snapshot;
+
+//Made up input so the runner has something to do, mashes left/right and jump like a bored player
+unsigned int MashInput(const Game &game, int tick)
+{
+  if (game.current_state == MENU)
+    return (tick % 2) ? (1u << ENTER) : 0; //Start a game as soon as we're on the menu
+
+  if (game.game_over)
+    return (tick % 2) ? (1u << R) : 0; //Straight back in for another go
+
+  unsigned int input = 0;
+
+  if ((tick / 90) % 2)
+    input |= 1u << RIGHT;
+  else
+    input |= 1u << LEFT;
+
+  if (tick % 20 < 10)
+    input |= 1u << X;
+
+  return input;
+}
+
+int main(int argc, char **argv)
+{
+  long long ticks = 1000000;
+  unsigned int seed = 1;
+  const char *record_path = NULL;
+  const char *replay_path = NULL;
+  const char *profile_path = NULL;
+  const char *trace_path = NULL;
+  int enemy_spawns = 1;
+  bool use_bot = false;
+  const char *restore_path = NULL;
+  const char *save_path = NULL;
+
+  for (int i = 1; i < argc; ++i)
+  {
+    if (strcmp(argv[i], "-ticks") == 0 && i + 1 < argc)
+    {
+      ticks = atoll(argv[++i]);
+    }
+    else if (strcmp(argv[i], "-seed") == 0 && i + 1 < argc)
+    {
+      seed = (unsigned int)strtoul(argv[++i], NULL, 10);
+    }
+    else if (strcmp(argv[i], "-record") == 0 && i + 1 < argc)
+    {
+      record_path = argv[++i];
+    }
+    else if (strcmp(argv[i], "-replay") == 0 && i + 1 < argc)
+    {
+      replay_path = argv[++i];
+    }
+    else if (strcmp(argv[i], "-profile") == 0 && i + 1 < argc)
+    {
+      profile_path = argv[++i];
+      profiling = true;
+    }
+    else if (strcmp(argv[i], "-trace") == 0 && i + 1 < argc)
+    {
+      trace_path = argv[++i];
+      tracing = true;
+    }
+    else if (strcmp(argv[i], "-enemies") == 0 && i + 1 < argc)
+    {
+      enemy_spawns = atoi(argv[++i]);
+    }
+    else if (strcmp(argv[i], "-bot") == 0)
+    {
+      use_bot = true;
+    }
+    else if (strcmp(argv[i], "-restore") == 0 && i + 1 < argc)
+    {
+      restore_path = argv[++i];
+    }
+    else if (strcmp(argv[i], "-save") == 0 && i + 1 < argc)
+    {
+      save_path = argv[++i];
+    }
+    else
+    {
+      fprintf(stderr, "Usage: %s [-ticks n] [-seed n] [-record file] [-replay file] [-profile file] [-trace file] [-enemies n] [-bot] [-restore file] [-save file]\n", argv[0]);
+      return 1;
+    }
+  }
+
+  if (restore_path && (record_path || replay_path))
+  {
+    fprintf(stderr, "Replays start from the menu, they can't be used with -restore\n");
+    return 1;
+  }
+
+  ReplayRecorder recorder = {NULL, 0, 0, 0};
+  ReplayPlayer replay = {NULL, 0, 0, 0, 0, 0};
+
+  if (replay_path)
+  {
+    if (!StartPlayback(replay, replay_path))
+    {
+      fprintf(stderr, "Couldn't read replay %s\n", replay_path);
+      return 1;
+    }
+
+    seed = replay.seed;
+    ticks = replay.ticks;
+  }
+
+  if (record_path && !StartRecording(recorder, record_path, seed))
+  {
+    fprintf(stderr, "Couldn't open %s for recording\n", record_path);
+    return 1;
+  }
+
+  Game game;
+  InitGame(game, seed);
+  game.enemy_spawns = enemy_spawns;
+  InitBot(bot, game);
+
+  if (restore_path)
+  {
+    if (!ReadSnapshot(restore_path, snapshot))
+    {
+      fprintf(stderr, "Couldn't restore %s, it's missing, damaged or from a different build\n", restore_path);
+      return 1;
+    }
+
+    RestoreSnapshot(game, snapshot);
+    seed = game.seed;
+  }
+
+  long long event_counts[EVENT_SUBMIT_SCORE + 1] = {0};
+  int games = 0;
+  int best = 0;
+  int most_enemies = 0;
+
+  //Step times for the game the bot is playing now
+  long long game_steps = 0;
+  double game_step_time = 0;
+  double slowest_step = 0;
+
+  chrono::steady_clock::time_point start = chrono::steady_clock::now();
+
+  for (long long tick = 0; tick < ticks; ++tick)
+  {
+    bool was_over = game.game_over;
+    unsigned int input;
+
+    if (replay_path)
+    {
+      if (!NextTick(replay, input))
+      {
+        ticks = tick;
+        break;
+      }
+    }
+    else if (use_bot)
+    {
+      int games_before = bot.stats.games;
+      input = BotInput(bot, game);
+
+      if (bot.stats.games != games_before)
+      {
+        printf("bot game %i: climbed %i pixels, score %i, steps avg %.2fus slowest %.2fus\n", bot.stats.games, bot.stats.last_climb,
+          bot.stats.last_score, game_step_time / game_steps * 1000, slowest_step * 1000);
+
+        game_steps = 0;
+        game_step_time = 0;
+        slowest_step = 0;
+      }
+    }
+    else
+    {
+      input = MashInput(game, (int)tick);
+    }
+
+    RecordTick(recorder, input);
+
+    if (use_bot)
+    {
+      double step_start = ProfileNow();
+      StepGame(game, input);
+      double step = ProfileNow() - step_start;
+
+      ++game_steps;
+      game_step_time += step;
+
+      if (step > slowest_step)
+        slowest_step = step;
+    }
+    else
+    {
+      StepGame(game, input);
+    }
+
+    for (int i = 0; i < game.num_events; ++i)
+      ++event_counts[game.events[i].type];
+
+    if (game.num_enemies > most_enemies)
+      most_enemies = game.num_enemies;
+
+    if (game.game_over && !was_over)
+    {
+      ++games;
+      if (game.highest > best)
+        best = game.highest;
+    }
+  }
+
+  double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+  StopRecording(recorder);
+  StopPlayback(replay);
+
+  if (profile_path && !WriteProfileCSV(profile_path))
+    fprintf(stderr, "Couldn't write profile to %s\n", profile_path);
+
+  //Only the last trace_capacity events are kept, so this is the end of the run
+  if (trace_path)
+  {
+    WriteTrace(trace_path, 0);
+    WaitForTraceWrites();
+  }
+
+  if (save_path)
+  {
+    TakeSnapshot(game, snapshot);
+
+    if (!WriteSnapshot(save_path, snapshot))
+      fprintf(stderr, "Couldn't save to %s\n", save_path);
+  }
+
+  if (restore_path || save_path)
+  {
+    //How long a round trip takes, to be sure it's cheap enough for every tick
+    const int rounds = 10000;
+    double round_start = ProfileNow();
+
+    for (int i = 0; i < rounds; ++i)
+    {
+      TakeSnapshot(game, snapshot);
+      RestoreSnapshot(game, snapshot);
+    }
+
+    printf("snapshot: %i bytes, take and restore %.2fus\n", (int)sizeof(Snapshot), (ProfileNow() - round_start) * 1000 / rounds);
+  }
+
+  printf("ticks: %lld in %.3fs (%.0f ticks/s)\n", ticks, seconds, ticks / seconds);
+  printf("games: %d, best climb: %i pixels\n", games, best);
+  printf("final state: seed %u, rand %08x, highest %i, score %i, stars %i\n", seed, game.rand_state, game.highest, game.score, game.stars);
+  printf("most enemies at once: %i\n", most_enemies);
+  printf("sounds: %lld, song started: %lld, paused: %lld, stopped: %lld\n", event_counts[EVENT_SOUND], event_counts[EVENT_SONG_PLAY], event_counts[EVENT_SONG_PAUSE], event_counts[EVENT_SONG_STOP]);
+  printf("scores submitted: %lld\n", event_counts[EVENT_SUBMIT_SCORE]);
+
+  if (use_bot && bot.stats.games > 0)
+    printf("bot: %i games, best climb %i pixels, average %.0f\n", bot.stats.games, bot.stats.best_climb,
+      (double)bot.stats.total_climb / bot.stats.games);
+
+  return 0;
+}
@@ -0,0 +1,125 @@
+//Builds the asset pack the game loads from, see pack.h for the format.
+//Files are stored under the name they're given on the command line, which is the path the game asks for,
+//so run it from the top folder.
+//
+//Build: g++ -O2 -I.. packer.cpp ../pack.cpp -o packer
+//Usage: packer out.pack file...
+//       tools/packer assets.pack Assets/Images/*.png Assets/Fonts/*.ttf Assets/Audio/*
+
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "../pack.h"
+
+using namespace std;
+
+static void WriteU16(FILE *file, unsigned int value)
+{
+  fputc(value & 0xff, file);
+  fputc((value >> 8) & 0xff, file);
+}
+
+static void WriteU32(FILE *file, unsigned int value)
+{
+  WriteU16(file, value & 0xffff);
+  WriteU16(file, (value >> 16) & 0xffff);
+}
+
+//Reads the whole of path in to contents
+static bool ReadFile(const char *path, vector<unsigned char> &contents)
+{
+  FILE *file = fopen(path, "rb");
+
+  if (!file)
+    return false;
+
+  fseek(file, 0, SEEK_END);
+  long size = ftell(file);
+  fseek(file, 0, SEEK_SET);
+
+  contents.resize(size);
+  bool ok = size >= 0 && fread(contents.data(), 1, size, file) == (size_t)size;
+
+  fclose(file);
+  return ok;
+}
+
+int main(int argc, char **argv)
+{
+  if (argc < 3)
+  {
+    fprintf(stderr, "Usage: %s out.pack file...\n", argv[0]);
+    return 1;
+  }
+
+  int count = argc - 2;
+  char **names = argv + 2;
+
+  if (count > 0xffff)
+  {
+    fprintf(stderr, "Too many files, a pack holds at most 65535\n");
+    return 1;
+  }
+
+  vector<vector<unsigned char> > files(count);
+  unsigned int index_size = 0;
+
+  for (int i = 0; i < count; ++i)
+  {
+    if (strlen(names[i]) > 255)
+    {
+      fprintf(stderr, "Name too long: %s\n", names[i]);
+      return 1;
+    }
+
+    if (!ReadFile(names[i], files[i]))
+    {
+      fprintf(stderr, "Couldn't read %s\n", names[i]);
+      return 1;
+    }
+
+    index_size += 2 + strlen(names[i]) + 8;
+  }
+
+  FILE *out = fopen(argv[1], "wb");
+
+  if (!out)
+  {
+    fprintf(stderr, "Couldn't open %s for writing\n", argv[1]);
+    return 1;
+  }
+
+  fwrite("TCPK", 1, 4, out);
+  WriteU16(out, pack_version);
+  WriteU16(out, count);
+
+  //The files go straight after the index in the same order
+  unsigned int offset = 8 + index_size;
+
+  for (int i = 0; i < count; ++i)
+  {
+    unsigned int length = strlen(names[i]);
+
+    fputc(PackTypeFor(names[i]), out);
+    fputc(length, out);
+    fwrite(names[i], 1, length, out);
+    WriteU32(out, offset);
+    WriteU32(out, files[i].size());
+
+    offset += files[i].size();
+  }
+
+  for (int i = 0; i < count; ++i)
+    fwrite(files[i].data(), 1, files[i].size(), out);
+
+  if (fclose(out) != 0)
+  {
+    fprintf(stderr, "Couldn't write %s\n", argv[1]);
+    return 1;
+  }
+
+  printf("%s: %i files, %u bytes\n", argv[1], count, offset);
+
+  return 0;
+}
@@ -0,0 +1,171 @@
+//Stub leaderboard server for trying out the score client, see scoreclient.h.
+//Takes one HTTP request at a time, prints each score posted to it and answers 200, or 503 for the first -fail
+//requests so the retries can be watched. -delay holds every answer back to look like a slow server.
+//
+//Build: g++ -O2 score_server.cpp -o score_server        (add -lws2_32 on Windows)
+//Usage: score_server [-port n] [-fail n] [-delay ms]
+//       then start the game with -scores localhost:n
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <string>
+#include <thread>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+typedef SOCKET Socket;
+#else
+#include <netinet/in.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <unistd.h>
+typedef int Socket;
+const Socket INVALID_SOCKET = -1;
+#endif
+
+using namespace std;
+
+static void CloseSocket(Socket socket)
+{
+#ifdef _WIN32
+  closesocket(socket);
+#else
+  close(socket);
+#endif
+}
+
+//Reads the headers and as much body as Content-Length says in to body, returns false if the request was cut short
+static bool ReadRequest(Socket client, string &body)
+{
+  string request;
+  char buffer[4096];
+  size_t header_end = string::npos;
+  size_t length = 0;
+
+  for (;;)
+  {
+    if (header_end == string::npos)
+    {
+      header_end = request.find("\r\n\r\n");
+
+      if (header_end != string::npos)
+      {
+        const char *content_length = strstr(request.c_str(), "Content-Length:");
+
+        if (content_length && content_length < request.c_str() + header_end)
+          length = strtoul(content_length + 15, NULL, 10);
+
+        header_end += 4;
+      }
+    }
+
+    if (header_end != string::npos && request.size() >= header_end + length)
+    {
+      body = request.substr(header_end, length);
+      return true;
+    }
+
+    int received = recv(client, buffer, sizeof(buffer), 0);
+
+    if (received <= 0)
+      return false;
+
+    request.append(buffer, received);
+  }
+}
+
+int main(int argc, char **argv)
+{
+  int port = 8080;
+  int fail = 0;
+  int delay = 0;
+
+  for (int i = 1; i < argc; ++i)
+  {
+    if (strcmp(argv[i], "-port") == 0 && i + 1 < argc)
+      port = atoi(argv[++i]);
+    else if (strcmp(argv[i], "-fail") == 0 && i + 1 < argc)
+      fail = atoi(argv[++i]);
+    else if (strcmp(argv[i], "-delay") == 0 && i + 1 < argc)
+      delay = atoi(argv[++i]);
+  }
+
+#ifdef _WIN32
+  WSADATA data;
+  WSAStartup(MAKEWORD(2, 2), &data);
+#else
+  //A client hanging up before its answer is sent would raise SIGPIPE and stop the server
+  signal(SIGPIPE, SIG_IGN);
+#endif
+
+  Socket listener = socket(AF_INET, SOCK_STREAM, 0);
+  int reuse = 1;
+  setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, (const char *)&reuse, sizeof(reuse));
+
+  sockaddr_in address;
+  memset(&address, 0, sizeof(address));
+  address.sin_family = AF_INET;
+  address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  address.sin_port = htons(port);
+
+  if (listener == INVALID_SOCKET || bind(listener, (sockaddr *)&address, sizeof(address)) != 0 || listen(listener, 8) != 0)
+  {
+    fprintf(stderr, "Couldn't listen on port %i\n", port);
+    return 1;
+  }
+
+  printf("Listening on 127.0.0.1:%i\n", port);
+  fflush(stdout);
+
+  int requests = 0;
+  int scores = 0;
+
+  for (;;)
+  {
+    Socket client = accept(listener, NULL, NULL);
+
+    if (client == INVALID_SOCKET)
+      continue;
+
+    string body;
+
+    if (ReadRequest(client, body))
+    {
+      ++requests;
+
+      if (delay > 0)
+        this_thread::sleep_for(chrono::milliseconds(delay));
+
+      const char *reply;
+
+      if (requests <= fail)
+      {
+        reply = "HTTP/1.0 503 Service Unavailable\r\nContent-Length: 0\r\n\r\n";
+        printf("request %i: failed on purpose\n", requests);
+      }
+      else
+      {
+        reply = "HTTP/1.0 200 OK\r\nContent-Length: 0\r\n\r\n";
+
+        for (size_t start = 0; start < body.size();)
+        {
+          size_t end = body.find('\n', start);
+
+          if (end == string::npos)
+            end = body.size();
+
+          printf("request %i: score %i: %s\n", requests, ++scores, body.substr(start, end - start).c_str());
+          start = end + 1;
+        }
+      }
+
+      fflush(stdout);
+      send(client, reply, (int)strlen(reply), 0);
+    }
+
+    CloseSocket(client);
+  }
+}
@@ -0,0 +1,269 @@
+//End to end test of the score client in scoreclient.h against the stub server in score_server.cpp.
+//Starts the stub, queues scores, kills it part way and checks what's left waits in the spool across a restart of
+//the client, then starts the stub again and checks every score arrived exactly once, in batches no bigger than
+//score_batch_size, and the spool ended up empty. Exits with 0 if it all worked.
+//Runs the stub as a child process so it can be killed, so it's POSIX only.
+//
+//Build: g++ -O2 score_server.cpp -o score_server
+//       g++ -O2 -pthread -I.. score_test.cpp ../scoreclient.cpp ../files.cpp ../trace.cpp ../profiler.cpp -o score_test
+//Usage: score_test [-server path] [-port n]        takes around 10 seconds, most of it waiting on retries
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "../scoreclient.h"
+
+using namespace std;
+
+const char *spool_path = "score_test.spool";
+
+//Scores queued in each part, every one is different so they can be told apart at the other end
+const int first_scores = 40;
+const int second_scores = 40;
+const int total_scores = first_scores + second_scores;
+
+//Longest to wait for anything, the client backs off for a second then two then four after failures
+const int wait_seconds = 20;
+
+struct Server
+{
+  pid_t pid;
+  thread reader;
+};
+
+//Everything the stub has printed about what it was sent
+static mutex received_lock;
+static vector<int> received(total_scores + 1); //How many times each score arrived
+static vector<int> batch_sizes; //Scores in each request that worked
+static int arrived = 0;
+
+static int failures = 0;
+
+static void Check(bool ok, const char *what)
+{
+  printf("%s: %s\n", ok ? "ok  " : "FAIL", what);
+
+  if (!ok)
+    ++failures;
+}
+
+//Reads "request n: score m: name score when" lines from the stub until it goes away
+static void ReadServer(FILE *output)
+{
+  char line[256];
+  int last_request = 0;
+
+  while (fgets(line, sizeof(line), output))
+  {
+    int request, count, score;
+    unsigned int when;
+    char name[8];
+
+    if (sscanf(line, "request %d: score %d: %7s %d %u", &request, &count, name, &score, &when) != 5)
+      continue;
+
+    lock_guard<mutex> lock(received_lock);
+
+    if (request != last_request)
+      batch_sizes.push_back(0);
+
+    last_request = request;
+    ++batch_sizes.back();
+
+    if (score >= 1 && score <= total_scores)
+      ++received[score];
+
+    ++arrived;
+  }
+
+  fclose(output);
+}
+
+static bool StartServer(Server &server, const char *server_path, const char *port, const char *fail)
+{
+  int pipes[2];
+
+  if (pipe(pipes) != 0)
+    return false;
+
+  server.pid = fork();
+
+  if (server.pid < 0)
+    return false;
+
+  if (server.pid == 0)
+  {
+    dup2(pipes[1], STDOUT_FILENO);
+    close(pipes[0]);
+    close(pipes[1]);
+    execl(server_path, server_path, "-port", port, "-fail", fail, (char *)NULL);
+    _exit(127);
+  }
+
+  close(pipes[1]);
+
+  FILE *output = fdopen(pipes[0], "r");
+  char line[256];
+
+  //Wait for it to be listening before anything is sent to it
+  if (!output || !fgets(line, sizeof(line), output) || strncmp(line, "Listening", 9) != 0)
+    return false;
+
+  server.reader = thread(ReadServer, output);
+  return true;
+}
+
+static void KillServer(Server &server)
+{
+  kill(server.pid, SIGTERM);
+  waitpid(server.pid, NULL, 0);
+  server.reader.join();
+}
+
+static int Arrived()
+{
+  lock_guard<mutex> lock(received_lock);
+  return arrived;
+}
+
+//Waits until count scores have arrived, returns false if they didn't in time
+static bool WaitForScores(int count)
+{
+  chrono::steady_clock::time_point give_up = chrono::steady_clock::now() + chrono::seconds(wait_seconds);
+
+  while (Arrived() < count)
+  {
+    if (chrono::steady_clock::now() > give_up)
+      return false;
+
+    this_thread::sleep_for(chrono::milliseconds(50));
+  }
+
+  return true;
+}
+
+//Reads the scores in the spool, one "name score when" line each
+static vector<int> ReadSpool()
+{
+  vector<int> scores;
+  FILE *file = fopen(spool_path, "rb");
+
+  if (!file)
+    return scores;
+
+  char name[8];
+  int score;
+  unsigned int when;
+
+  while (fscanf(file, "%7s %d %u", name, &score, &when) == 3)
+    scores.push_back(score);
+
+  fclose(file);
+  return scores;
+}
+
+int main(int argc, char **argv)
+{
+  const char *server_path = "./score_server";
+  const char *port = "8099";
+
+  for (int i = 1; i < argc; ++i)
+  {
+    if (strcmp(argv[i], "-server") == 0 && i + 1 < argc)
+    {
+      server_path = argv[++i];
+    }
+    else if (strcmp(argv[i], "-port") == 0 && i + 1 < argc)
+    {
+      port = argv[++i];
+    }
+    else
+    {
+      fprintf(stderr, "Usage: %s [-server path] [-port n]\n", argv[0]);
+      return 1;
+    }
+  }
+
+  remove(spool_path);
+
+  //The first two requests fail, so the first scores go out after backing off twice
+  Server server;
+
+  if (!StartServer(server, server_path, port, "2"))
+  {
+    fprintf(stderr, "Couldn't start %s\n", server_path);
+    return 1;
+  }
+
+  StartScoreClient("127.0.0.1", port, "/scores", spool_path);
+
+  for (int i = 1; i <= first_scores; ++i)
+    QueueScore("TST", i, 1000 + i);
+
+  Check(WaitForScores(first_scores), "first scores arrive after the server stops failing");
+  Check(GetScoreClientStats().failures >= 2, "the failed requests were retried");
+
+  //Down part way, the rest can't go anywhere and have to wait in the spool
+  KillServer(server);
+
+  for (int i = first_scores + 1; i <= total_scores; ++i)
+    QueueScore("TST", i, 1000 + i);
+
+  this_thread::sleep_for(chrono::seconds(2));
+  StopScoreClient();
+
+  vector<int> spooled = ReadSpool();
+  bool all_spooled = (int)spooled.size() == second_scores;
+
+  for (size_t i = 0; i < spooled.size(); ++i)
+    all_spooled = all_spooled && spooled[i] == first_scores + 1 + (int)i;
+
+  Check(all_spooled, "scores not sent yet are in the spool after stopping");
+
+  //Back up, and a new client picks up where the last left off from the spool
+  if (!StartServer(server, server_path, port, "0"))
+  {
+    fprintf(stderr, "Couldn't start %s again\n", server_path);
+    return 1;
+  }
+
+  StartScoreClient("127.0.0.1", port, "/scores", spool_path);
+
+  Check(WaitForScores(total_scores), "spooled scores arrive after a restart");
+
+  //Long enough for anything that shouldn't have been sent again to turn up, and for the spool to be rewritten
+  this_thread::sleep_for(chrono::seconds(1));
+  StopScoreClient();
+  KillServer(server);
+
+  bool once = true;
+
+  for (int i = 1; i <= total_scores; ++i)
+    once = once && received[i] == 1;
+
+  Check(once && arrived == total_scores, "every score arrived exactly once");
+
+  bool batches_fit = !batch_sizes.empty();
+
+  for (size_t i = 0; i < batch_sizes.size(); ++i)
+    batches_fit = batches_fit && batch_sizes[i] <= score_batch_size;
+
+  Check(batches_fit, "no request carried more than score_batch_size scores");
+  Check(batch_sizes.size() > 0 && batch_sizes[0] == score_batch_size, "the first request carried a full batch");
+  Check(ReadSpool().empty(), "the spool is empty at the end");
+
+  remove(spool_path);
+
+  printf("%s\n", failures == 0 ? "all passed" : "FAILED");
+  return failures == 0 ? 0 : 1;
+}
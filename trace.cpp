@@ -0,0 +1,137 @@
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "trace.h"
+
+using namespace std;
+
+bool tracing = false;
+
+struct TraceEvent
+{
+  const char *name;
+  double start; //Microseconds
+  double duration; //Negative for instant events
+  int thread;
+  atomic<unsigned long long> sequence; //Index + 1 of the event in this slot once it's been written, 0 while it's being written
+};
+
+static TraceEvent events[trace_capacity];
+static atomic<unsigned long long> next_event(0);
+
+//Small ids for threads so the timeline shows one row each
+static atomic<int> next_thread(1);
+static thread_local int thread_id = 0;
+
+static atomic<int> pending_writes(0);
+
+double TraceNow()
+{
+  return chrono::duration<double, micro>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static void Record(const char *name, double start, double duration)
+{
+  if (thread_id == 0)
+    thread_id = next_thread++;
+
+  unsigned long long index = next_event.fetch_add(1, memory_order_relaxed);
+  TraceEvent &event = events[index & (trace_capacity - 1)];
+
+  event.sequence.store(0, memory_order_relaxed);
+  atomic_thread_fence(memory_order_release);
+
+  event.name = name;
+  event.start = start;
+  event.duration = duration;
+  event.thread = thread_id;
+
+  event.sequence.store(index + 1, memory_order_release);
+}
+
+void TraceComplete(const char *name, double start, double duration)
+{
+  Record(name, start, duration);
+}
+
+void TraceInstant(const char *name)
+{
+  Record(name, TraceNow(), -1);
+}
+
+struct TraceCopy
+{
+  const char *name;
+  double start;
+  double duration;
+  int thread;
+};
+
+static void WriteEvents(string path, vector<TraceCopy> copies)
+{
+  FILE *file = fopen(path.c_str(), "w");
+
+  if (file)
+  {
+    fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+
+    for (size_t i = 0; i < copies.size(); ++i)
+    {
+      const TraceCopy &event = copies[i];
+
+      if (event.duration < 0)
+        fprintf(file, "{\"name\":\"%s\",\"ph\":\"i\",\"s\":\"t\",\"ts\":%.3f,\"pid\":1,\"tid\":%d}", event.name, event.start, event.thread);
+      else
+        fprintf(file, "{\"name\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%d}", event.name, event.start, event.duration, event.thread);
+
+      fprintf(file, i + 1 < copies.size() ? ",\n" : "\n");
+    }
+
+    fprintf(file, "]}\n");
+    fclose(file);
+  }
+
+  --pending_writes;
+}
+
+void WriteTrace(const char *path, double seconds)
+{
+  unsigned long long end = next_event.load(memory_order_acquire);
+  unsigned long long begin = end > (unsigned long long)trace_capacity ? end - trace_capacity : 0;
+  double cutoff = seconds > 0 ? TraceNow() - seconds * 1000000 : 0;
+
+  vector<TraceCopy> copies;
+  copies.reserve((size_t)(end - begin));
+
+  for (unsigned long long index = begin; index < end; ++index)
+  {
+    const TraceEvent &event = events[index & (trace_capacity - 1)];
+
+    //Skip anything being written right now or already overwritten by a newer event
+    if (event.sequence.load(memory_order_acquire) != index + 1)
+      continue;
+
+    TraceCopy copy = {event.name, event.start, event.duration, event.thread};
+
+    atomic_thread_fence(memory_order_acquire);
+    if (event.sequence.load(memory_order_relaxed) != index + 1)
+      continue;
+
+    if (copy.start + (copy.duration > 0 ? copy.duration : 0) >= cutoff)
+      copies.push_back(copy);
+  }
+
+  ++pending_writes;
+  thread(WriteEvents, string(path), copies).detach();
+}
+
+void WaitForTraceWrites()
+{
+  while (pending_writes > 0)
+    this_thread::sleep_for(chrono::milliseconds(1));
+}
@@ -0,0 +1,42 @@
+//Timeline recorder, keeps the most recent trace_capacity events in a ring buffer and writes them out as
+//Chrome trace JSON, open the file in chrome://tracing or ui.perfetto.dev.
+//Recording is lock free so it's safe from any thread, and costs a clock read and a few stores per event.
+
+#ifndef TRACE_H
+#define TRACE_H
+
+//Must be a power of two
+const int trace_capacity = 1 << 16;
+
+//Set to true to start recording
+extern bool tracing;
+
+double TraceNow(); //Current time in microseconds on the same clock as the profiler
+void TraceComplete(const char *name, double start, double duration); //Records something that started at start and took duration microseconds, name must live forever
+void TraceInstant(const char *name); //Records something that happened right now
+
+//Writes events from the last seconds to path as Chrome trace JSON, or everything still in the buffer if seconds is 0.
+//The events are copied straight away but the file is written on another thread so it won't cause a hitch of its own
+void WriteTrace(const char *path, double seconds);
+void WaitForTraceWrites(); //Blocks until every WriteTrace has finished, call before exiting
+
+//Records from construction to the end of the scope
+struct TraceScope
+{
+  const char *name;
+  double start;
+
+  TraceScope(const char *name) : name(name), start(tracing ? TraceNow() : 0) {}
+
+  ~TraceScope()
+  {
+    if (tracing)
+      TraceComplete(name, start, TraceNow() - start);
+  }
+};
+
+#define TRACE_JOIN(a, b) a##b
+#define TRACE_NAME(line) TRACE_JOIN(trace_scope_, line)
+#define TRACE_SCOPE(name) TraceScope TRACE_NAME(__LINE__)(name)
+
+#endif
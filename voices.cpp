@@ -0,0 +1,190 @@
+#include <Allegro5\allegro.h>
+#include <Allegro5\allegro_audio.h>
+
+#include "voices.h"
+
+struct Voice
+{
+  ALLEGRO_SAMPLE_INSTANCE *instance;
+  int sound;
+  double started;
+  double ends; //Worked out from the sample length when it starts, so checking if it's free doesn't have to ask the audio thread
+};
+
+struct VoiceSound
+{
+  int first; //Its voices are voices[first] up to first + settings.voices
+  VoiceSettings settings;
+  double length; //Seconds
+  double last_started;
+};
+
+static Voice voices[max_voices];
+static int num_voices = 0;
+
+static VoiceSound *voice_sounds = NULL;
+static int num_voice_sounds = 0;
+
+static int budget = 0;
+static VoiceStats stats = {0, 0, 0, 0, 0};
+
+void CreateVoices(ALLEGRO_SAMPLE **samples, const VoiceSettings *settings, int count, int max_playing)
+{
+  voice_sounds = new VoiceSound[count];
+  num_voice_sounds = count;
+  budget = max_playing;
+
+  for (int i = 0; i < count; ++i)
+  {
+    VoiceSound &sound = voice_sounds[i];
+
+    sound.first = num_voices;
+    sound.settings = settings[i];
+    sound.settings.voices = 0;
+    sound.length = 0;
+    sound.last_started = -1e9;
+
+    if (!samples[i])
+      continue;
+
+    sound.length = (double)al_get_sample_length(samples[i]) / al_get_sample_frequency(samples[i]);
+
+    for (int j = 0; j < settings[i].voices && num_voices < max_voices; ++j)
+    {
+      ALLEGRO_SAMPLE_INSTANCE *instance = al_create_sample_instance(samples[i]);
+
+      if (!instance)
+        break;
+
+      al_set_sample_instance_playmode(instance, ALLEGRO_PLAYMODE_ONCE);
+      al_attach_sample_instance_to_mixer(instance, al_get_default_mixer());
+
+      Voice &voice = voices[num_voices++];
+      voice.instance = instance;
+      voice.sound = i;
+      voice.started = 0;
+      voice.ends = 0;
+
+      ++sound.settings.voices;
+    }
+  }
+}
+
+//Stops whatever voice is playing and starts it again from the beginning
+static void StartVoice(Voice &voice, double now)
+{
+  if (voice.ends > now)
+  {
+    al_stop_sample_instance(voice.instance);
+    ++stats.steals;
+  }
+
+  al_set_sample_instance_position(voice.instance, 0);
+  al_play_sample_instance(voice.instance);
+
+  voice.started = now;
+  voice.ends = now + voice_sounds[voice.sound].length;
+}
+
+bool PlayVoice(int sound_id)
+{
+  if (sound_id < 0 || sound_id >= num_voice_sounds)
+    return false;
+
+  VoiceSound &sound = voice_sounds[sound_id];
+  double now = al_get_time();
+
+  if (sound.settings.voices == 0)
+    return false;
+
+  if (now - sound.last_started < sound.settings.min_gap)
+  {
+    ++stats.limited;
+    return false;
+  }
+
+  //A free voice of its own, or failing that the one of its own that started first
+  Voice *own = NULL;
+
+  for (int i = sound.first; i < sound.first + sound.settings.voices; ++i)
+  {
+    if (voices[i].ends <= now)
+    {
+      own = &voices[i];
+      break;
+    }
+
+    if (!own || voices[i].started < own->started)
+      own = &voices[i];
+  }
+
+  //Restarting one of its own doesn't change how many are playing
+  if (own->ends <= now)
+  {
+    int playing = 0;
+    Voice *lowest = NULL;
+
+    for (int i = 0; i < num_voices; ++i)
+    {
+      if (voices[i].ends <= now)
+        continue;
+
+      ++playing;
+
+      int priority = voice_sounds[voices[i].sound].settings.priority;
+
+      if (!lowest || priority < voice_sounds[lowest->sound].settings.priority ||
+          (priority == voice_sounds[lowest->sound].settings.priority && voices[i].started < lowest->started))
+        lowest = &voices[i];
+    }
+
+    if (playing >= budget && lowest)
+    {
+      if (voice_sounds[lowest->sound].settings.priority > sound.settings.priority)
+      {
+        ++stats.drops;
+        return false;
+      }
+
+      al_stop_sample_instance(lowest->instance);
+      lowest->ends = 0;
+      ++stats.steals;
+    }
+  }
+
+  StartVoice(*own, now);
+
+  sound.last_started = now;
+  ++stats.plays;
+  return true;
+}
+
+VoiceStats GetVoiceStats()
+{
+  double now = al_get_time();
+
+  stats.playing = 0;
+
+  for (int i = 0; i < num_voices; ++i)
+  {
+    if (voices[i].ends > now)
+      ++stats.playing;
+  }
+
+  return stats;
+}
+
+void DestroyVoices()
+{
+  for (int i = 0; i < num_voices; ++i)
+  {
+    al_stop_sample_instance(voices[i].instance);
+    al_destroy_sample_instance(voices[i].instance);
+  }
+
+  delete[] voice_sounds;
+
+  voice_sounds = NULL;
+  num_voice_sounds = 0;
+  num_voices = 0;
+}
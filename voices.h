@@ -0,0 +1,43 @@
+//Plays the sound effects on a fixed set of sample instances made up front, instead of al_play_sample grabbing
+//whatever reserved voice is free and silently giving up when there isn't one.
+//Each sound gets its own few voices, so a shower of coins can only ever use the coin's. When more is playing than
+//the mixer budget allows, the lowest priority voice is cut off for the new one, or the new one is dropped if
+//everything playing matters more. Sounds retriggered faster than their min_gap are skipped.
+
+#ifndef VOICES_H
+#define VOICES_H
+
+#include <Allegro5\allegro.h>
+#include <Allegro5\allegro_audio.h>
+
+//Most sample instances that can be made across every sound
+const int max_voices = 32;
+
+struct VoiceSettings
+{
+  int voices; //Most copies of the sound that can play at once, the oldest is restarted for a new one past this
+  int priority; //Higher takes a voice from lower when the budget's used up, the highest should be a sound that can't drop
+  double min_gap; //Seconds after it last started before it can start again, 0 for no limit
+};
+
+struct VoiceStats
+{
+  int playing; //Voices playing right now
+  long long plays;
+  long long steals; //Voices cut off part way through to play something else
+  long long drops; //Sounds not played because everything playing had a higher priority
+  long long limited; //Sounds not played because they were retriggered inside min_gap
+};
+
+//Makes settings[i].voices sample instances for each of the count samples and attaches them to the default mixer.
+//At most max_playing play at once. Samples that are NULL are skipped and never play
+void CreateVoices(ALLEGRO_SAMPLE **samples, const VoiceSettings *settings, int count, int max_playing);
+
+//Starts sound from the beginning, returns false if it was dropped or rate limited
+bool PlayVoice(int sound);
+
+VoiceStats GetVoiceStats();
+
+void DestroyVoices(); //Stops and destroys every instance, call before destroying the samples
+
+#endif